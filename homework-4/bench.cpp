@@ -0,0 +1,385 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "filter_pipeline.hpp"
+#include "ip.hpp"
+#include "ip_parser.hpp"
+#include "packed_ip.hpp"
+
+namespace {
+
+struct BenchConfig {
+    std::string suite;
+    std::string file;
+    std::size_t lines = 2000000;
+    std::size_t repeat = 3;
+    std::uint32_t seed = 42;
+};
+
+void print_usage(const char* prog) {
+    std::cout <<
+        "Usage: " << prog << " <suite> [options] <ip_filter.tsv>\n"
+        "Suites:\n"
+        "  sort              std::sort of std::array<int, 4> vs uint32 (std::sort and radix sort)\n"
+        "  parse             getline + stringstream/stoi vs the block parser (scalar and SSSE3),\n"
+        "                    lines/s, plus a differential check of the two block parsers\n"
+        "  output            four filtered lists: a pass per list with operator<< (array and\n"
+        "                    uint32) vs the single-pass FilterPipeline\n"
+        "Input is scaled up to --lines lines: lines of the file are repeated with random\n"
+        "last two octets.\n"
+        "Options:\n"
+        "  --lines N         lines in the scaled input (default: 2000000)\n"
+        "  --repeat R        runs per variant, the best one is reported (default: 3)\n"
+        "  --seed S          random seed (default: 42)\n"
+        "\nExample:\n"
+        "  " << prog << " sort --lines 10000000 data/ip_filter.tsv\n"
+        "  " << prog << " parse data/ip_filter.tsv\n"
+        "  " << prog << " output data/ip_filter.tsv\n";
+}
+
+BenchConfig parse_args(int argc, char* argv[]) {
+    BenchConfig cfg;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto need = [&](const char* name) -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error(std::string("Missing value for ") + name);
+            }
+            return argv[++i];
+        };
+        if (arg == "--lines") {
+            cfg.lines = static_cast<std::size_t>(std::stoull(need("--lines")));
+        } else if (arg == "--repeat") {
+            cfg.repeat = static_cast<std::size_t>(std::stoul(need("--repeat")));
+        } else if (arg == "--seed") {
+            cfg.seed = static_cast<std::uint32_t>(std::stoul(need("--seed")));
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() != 2 || cfg.lines == 0 || cfg.repeat == 0) {
+        print_usage(argv[0]);
+        throw std::runtime_error("Invalid arguments");
+    }
+    cfg.suite = positional[0];
+    cfg.file = positional[1];
+    return cfg;
+}
+
+// Лучшее время из repeat прогонов, в секундах. prepare() не замеряется.
+double best_of(std::size_t repeat, const std::function<void()>& prepare, const std::function<void()>& run) {
+    double best = 0.0;
+    for (std::size_t i = 0; i < repeat; ++i) {
+        prepare();
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+// Вход, увеличенный до lines строк: строки файла по кругу, у адреса
+// случайные последние два октета, поля text2 и text3 — как в файле.
+struct ScaledInput {
+    std::string text;
+    std::vector<Ip> ips;
+};
+
+ScaledInput scale_input(const std::string& path, std::size_t lines, std::uint32_t seed) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+    std::vector<Ip> heads;
+    std::vector<std::string> tails;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        const std::size_t tab_pos = line.find('\t');
+        heads.push_back(parse_ip(line.substr(0, tab_pos)));
+        tails.push_back(tab_pos == std::string::npos ? std::string() : line.substr(tab_pos));
+    }
+    if (heads.empty()) {
+        throw std::runtime_error("No addresses in " + path);
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> octet_dist(0, 255);
+    ScaledInput input;
+    input.ips.reserve(lines);
+    input.text.reserve(lines * 32);
+    for (std::size_t i = 0; i < lines; ++i) {
+        Ip ip = heads[i % heads.size()];
+        ip[2] = octet_dist(rng);
+        ip[3] = octet_dist(rng);
+        input.ips.push_back(ip);
+        for (std::size_t k = 0; k < ip.size(); ++k) {
+            if (k != 0) {
+                input.text.push_back('.');
+            }
+            input.text += std::to_string(ip[k]);
+        }
+        input.text += tails[i % tails.size()];
+        input.text.push_back('\n');
+    }
+    return input;
+}
+
+void print_row(const char* name, double seconds, std::size_t lines, std::size_t bytes) {
+    std::cout << std::left << std::setw(20) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(3) << seconds << " s"
+              << std::setw(10) << std::setprecision(1) << static_cast<double>(lines) / 1e6 / seconds << " Mlines/s"
+              << std::setw(8) << bytes / (1024 * 1024) << " MiB\n";
+}
+
+int bench_sort(const BenchConfig& cfg) {
+    const ScaledInput input = scale_input(cfg.file, cfg.lines, cfg.seed);
+    const std::size_t n = input.ips.size();
+    std::cout << "Lines: " << n << '\n';
+
+    std::vector<PackedIp> packed;
+    packed.reserve(n);
+    for (const Ip& ip : input.ips) {
+        packed.push_back(pack_ip(ip));
+    }
+
+    std::vector<Ip> arrays;
+    const double array_seconds = best_of(
+        cfg.repeat, [&] { arrays = input.ips; },
+        [&] { std::sort(arrays.begin(), arrays.end(), std::greater<Ip>{}); });
+    print_row("array std::sort", array_seconds, n, n * sizeof(Ip));
+
+    std::vector<PackedIp> by_sort;
+    const double sort_seconds = best_of(
+        cfg.repeat, [&] { by_sort = packed; },
+        [&] { std::sort(by_sort.begin(), by_sort.end(), std::greater<PackedIp>{}); });
+    print_row("packed std::sort", sort_seconds, n, n * sizeof(PackedIp));
+
+    // Radix sort держит рядом буфер того же размера.
+    std::vector<PackedIp> by_radix;
+    const double radix_seconds = best_of(
+        cfg.repeat, [&] { by_radix = packed; }, [&] { radix_sort_descending(by_radix); });
+    print_row("packed radix", radix_seconds, n, 2 * n * sizeof(PackedIp));
+
+    std::vector<PackedIp> expected;
+    expected.reserve(n);
+    for (const Ip& ip : arrays) {
+        expected.push_back(pack_ip(ip));
+    }
+    if (expected != by_sort || expected != by_radix) {
+        std::cerr << "Error: packed order differs from std::sort of std::array<int, 4>\n";
+        return 1;
+    }
+    std::cout << "Same order: ok\n";
+    return 0;
+}
+
+#if defined(HOMEWORK4_HAVE_SSSE3)
+// Сравнивает parse_ip_simd и parse_ip_scalar на случайных строках из
+// цифр, точек и ограничителей. За строкой — либо '\n' и цифры следующей
+// строки, либо нули, как в конце данных.
+bool differential_check(std::size_t rounds, std::uint32_t seed) {
+    static const std::string alphabet = "0123456789...12525\t\r x";
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<std::size_t> length_dist(0, 20);
+    std::uniform_int_distribution<std::size_t> char_dist(0, alphabet.size() - 1);
+
+    std::string buffer;
+    for (std::size_t round = 0; round < rounds; ++round) {
+        buffer.clear();
+        if (round % 4 < 2) {
+            // Почти адрес: четыре группы по 1..4 цифры, иногда с порчей.
+            std::uniform_int_distribution<int> digits_dist(1, 4);
+            std::uniform_int_distribution<int> digit_dist(0, 9);
+            for (int k = 0; k < 4; ++k) {
+                if (k != 0) {
+                    buffer.push_back('.');
+                }
+                for (int d = digits_dist(rng); d > 0; --d) {
+                    buffer.push_back(static_cast<char>('0' + (d == 3 ? digit_dist(rng) % 3 : digit_dist(rng))));
+                }
+            }
+            if (round % 8 == 0) {
+                buffer[char_dist(rng) % buffer.size()] = alphabet[char_dist(rng)];
+            }
+        } else {
+            for (std::size_t i = length_dist(rng); i > 0; --i) {
+                buffer.push_back(alphabet[char_dist(rng)]);
+            }
+        }
+        const std::size_t length = buffer.size();
+        if (round % 2 == 0) {
+            buffer += "\n1.2.3.4\t5\t6\n123456789";
+        }
+        buffer.append(kParsePadding + 32, '\0');
+        const char* begin = buffer.data();
+        const char* end = begin + length;
+
+        PackedIp scalar_ip = 0;
+        PackedIp simd_ip = 0;
+        const char* scalar = parse_ip_scalar(begin, end, scalar_ip);
+        const char* simd = parse_ip_simd(begin, end, simd_ip);
+        if (scalar != simd || (scalar != nullptr && scalar_ip != simd_ip)) {
+            std::cerr << "Mismatch on input: \"" << std::string(begin, length) << "\"\n";
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+// Исходный разбор из main: std::getline, substr и parse_ip.
+std::vector<PackedIp> parse_stream(const std::string& text) {
+    std::istringstream in(text);
+    std::vector<PackedIp> ips;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        const std::size_t tab_pos = line.find('\t');
+        const std::string ip_text = line.substr(0, tab_pos);
+        ips.push_back(pack_ip(parse_ip(ip_text)));
+    }
+    return ips;
+}
+
+std::vector<PackedIp> parse_blocks(const std::string& text, bool simd) {
+    std::vector<PackedIp> ips;
+    std::size_t offset = 0;
+    for_each_ip(
+        [&](char* buffer, std::size_t size) {
+            const std::size_t n = std::min(size, text.size() - offset);
+            std::memcpy(buffer, text.data() + offset, n);
+            offset += n;
+            return n;
+        },
+        [&ips](PackedIp ip) { ips.push_back(ip); }, simd);
+    return ips;
+}
+
+int bench_parse(const BenchConfig& cfg) {
+    const ScaledInput input = scale_input(cfg.file, cfg.lines, cfg.seed);
+    const std::size_t n = input.ips.size();
+    std::cout << "Lines: " << n << ", " << input.text.size() / (1024 * 1024) << " MiB\n";
+
+    bool ok = true;
+#if defined(HOMEWORK4_HAVE_SSSE3)
+    ok = differential_check(1000000, cfg.seed);
+#endif
+
+    std::vector<PackedIp> expected;
+    expected.reserve(n);
+    for (const Ip& ip : input.ips) {
+        expected.push_back(pack_ip(ip));
+    }
+
+    auto measure = [&](const char* name, const std::function<std::vector<PackedIp>()>& parse) {
+        std::vector<PackedIp> ips;
+        const double seconds = best_of(cfg.repeat, [&] { ips.clear(); }, [&] { ips = parse(); });
+        print_row(name, seconds, n, input.text.size());
+        ok = ok && ips == expected;
+    };
+    measure("stream", [&] { return parse_stream(input.text); });
+    measure("blocks scalar", [&] { return parse_blocks(input.text, false); });
+#if defined(HOMEWORK4_HAVE_SSSE3)
+    measure("blocks ssse3", [&] { return parse_blocks(input.text, true); });
+#else
+    std::cout << "blocks ssse3        not built (configure with -DHOMEWORK4_NATIVE=ON)\n";
+#endif
+
+    if (!ok) {
+        std::cerr << "Error: parsers disagree\n";
+        return 1;
+    }
+    std::cout << "Same addresses: ok\n";
+    return 0;
+}
+
+// Вывод print(), перехваченный из std::cout.
+std::string capture_cout(const std::function<void()>& print) {
+    std::ostringstream captured;
+    std::streambuf* const saved = std::cout.rdbuf(captured.rdbuf());
+    print();
+    std::cout.rdbuf(saved);
+    return captured.str();
+}
+
+int bench_output(const BenchConfig& cfg) {
+    const ScaledInput input = scale_input(cfg.file, cfg.lines, cfg.seed);
+    const std::size_t n = input.ips.size();
+
+    std::vector<Ip> arrays = input.ips;
+    std::sort(arrays.begin(), arrays.end(), std::greater<Ip>{});
+    std::vector<PackedIp> packed;
+    packed.reserve(n);
+    for (const Ip& ip : arrays) {
+        packed.push_back(pack_ip(ip));
+    }
+    const FilterPipeline pipeline = make_report_pipeline();
+
+    std::string expected;
+    std::string output;
+    bool ok = true;
+    auto measure = [&](const char* name, const std::function<void()>& print) {
+        const double seconds = best_of(cfg.repeat, [&] { output.clear(); }, [&] { output = capture_cout(print); });
+        if (expected.empty()) {
+            expected = output;
+        }
+        ok = ok && output == expected;
+        print_row(name, seconds, n, output.size());
+    };
+    std::cout << "Lines: " << n << '\n';
+    measure("array cout", [&] { print_report(arrays); });
+    measure("packed cout", [&] { print_report(packed); });
+    measure("pipeline", [&] { pipeline.run(packed, std::cout); });
+
+    if (!ok) {
+        std::cerr << "Error: outputs differ\n";
+        return 1;
+    }
+    std::cout << "Same output: ok\n";
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const BenchConfig cfg = parse_args(argc, argv);
+        if (cfg.suite == "sort") {
+            return bench_sort(cfg);
+        }
+        if (cfg.suite == "parse") {
+            return bench_parse(cfg);
+        }
+        if (cfg.suite == "output") {
+            return bench_output(cfg);
+        }
+        print_usage(argv[0]);
+        return 1;
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ip.hpp"
+#include "packed_ip.hpp"
+
+// Четыре списка из задания по одному проходу на список, вывод через
+// operator<< по полю. Оставлено как эталон для FilterPipeline.
+template <typename Address>
+void print_report(const std::vector<Address>& ips) {
+    print_filtered(ips, [](const Address&) { return true; });
+
+    print_filtered(ips, [](const Address& ip) {
+        return filter_first(ip, FILTER_FIRST_OCTET);
+    });
+
+    print_filtered(ips, [](const Address& ip) {
+        return filter_first_second(ip,
+                                   FILTER_FIRST_OCTET_2,
+                                   FILTER_SECOND_OCTET_2);
+    });
+
+    print_filtered(ips, [](const Address& ip) {
+        return filter_any(ip, FILTER_ANY_OCTET);
+    });
+}
+
+namespace detail {
+
+// Текст октета "0".."255" с точкой после него: копируется всегда четыре
+// байта, позиция сдвигается на length.
+struct OctetText {
+    std::array<char, 4> text;
+    std::uint8_t length;
+};
+
+constexpr std::array<OctetText, 256> make_octet_texts() {
+    std::array<OctetText, 256> table{};
+    for (std::size_t value = 0; value < table.size(); ++value) {
+        OctetText& entry = table[value];
+        std::size_t n = 0;
+        if (value >= 100) {
+            entry.text[n++] = static_cast<char>('0' + value / 100);
+        }
+        if (value >= 10) {
+            entry.text[n++] = static_cast<char>('0' + value / 10 % 10);
+        }
+        entry.text[n++] = static_cast<char>('0' + value % 10);
+        entry.text[n++] = '.';
+        entry.length = static_cast<std::uint8_t>(n);
+    }
+    return table;
+}
+
+constexpr std::array<OctetText, 256> kOctetTexts = make_octet_texts();
+
+}  // namespace detail
+
+// Максимум "255.255.255.255\n" — 16 байт; столько же нужно и под
+// четырёхбайтовые копии из таблицы.
+constexpr std::size_t kIpTextSize = 16;
+
+// Пишет адрес с '\n' в out, возвращает длину.
+inline std::size_t format_ip(PackedIp ip, char* out) {
+    std::size_t n = 0;
+    for (unsigned shift = 24;; shift -= 8) {
+        const detail::OctetText& octet_text = detail::kOctetTexts[(ip >> shift) & 0xFF];
+        std::memcpy(out + n, octet_text.text.data(), octet_text.text.size());
+        n += octet_text.length;
+        if (shift == 0) {
+            break;
+        }
+    }
+    out[n - 1] = '\n';
+    return n;
+}
+
+// Фильтры вывода за один проход: адрес форматируется один раз и
+// дописывается в буфер каждого фильтра, которому он подходит. Затем
+// буферы пишутся в порядке регистрации, каждый одним write, — вывод
+// совпадает с print_report.
+class FilterPipeline {
+public:
+    using Predicate = bool (*)(PackedIp);
+
+    void add(Predicate predicate) {
+        predicates_.push_back(predicate);
+    }
+
+    void run(const std::vector<PackedIp>& ips, std::ostream& out) const {
+        std::vector<std::string> buffers(predicates_.size());
+        char text[kIpTextSize];
+        for (PackedIp ip : ips) {
+            std::size_t length = 0;
+            for (std::size_t i = 0; i < predicates_.size(); ++i) {
+                if (!predicates_[i](ip)) {
+                    continue;
+                }
+                if (length == 0) {
+                    length = format_ip(ip, text);
+                }
+                buffers[i].append(text, length);
+            }
+        }
+        for (const std::string& buffer : buffers) {
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        }
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Failed to write output");
+        }
+    }
+
+private:
+    std::vector<Predicate> predicates_;
+};
+
+// Те же четыре списка, что в print_report.
+inline FilterPipeline make_report_pipeline() {
+    FilterPipeline pipeline;
+    pipeline.add([](PackedIp) { return true; });
+    pipeline.add([](PackedIp ip) { return filter_first(ip, FILTER_FIRST_OCTET); });
+    pipeline.add([](PackedIp ip) {
+        return filter_first_second(ip, FILTER_FIRST_OCTET_2, FILTER_SECOND_OCTET_2);
+    });
+    pipeline.add([](PackedIp ip) { return filter_any(ip, FILTER_ANY_OCTET); });
+    return pipeline;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Исходное представление: адрес — четыре int, сортировка — std::sort
+// сравнением массивов. Оставлено как эталон для движка packed.
+using Ip = std::array<int, 4>;
+
+constexpr int FILTER_FIRST_OCTET = 1;
+constexpr int FILTER_FIRST_OCTET_2 = 46;
+constexpr int FILTER_SECOND_OCTET_2 = 70;
+constexpr int FILTER_ANY_OCTET = 46;
+
+inline Ip parse_ip(const std::string& text) {
+    Ip ip{0, 0, 0, 0};
+    std::stringstream stream(text);
+    std::string part;
+
+    for (std::size_t i = 0; i < ip.size(); ++i) {
+        if (!std::getline(stream, part, '.')) {
+            throw std::runtime_error("Invalid IP format");
+        }
+        ip[i] = std::stoi(part);
+    }
+
+    return ip;
+}
+
+inline void print_ip(const Ip& ip) {
+    std::cout << ip[0] << '.'
+              << ip[1] << '.'
+              << ip[2] << '.'
+              << ip[3] << '\n';
+}
+
+template <typename Predicate>
+void print_filtered(const std::vector<Ip>& ips, Predicate predicate) {
+    for (const Ip& ip : ips) {
+        if (predicate(ip)) {
+            print_ip(ip);
+        }
+    }
+}
+
+inline bool filter_first(const Ip& ip, int value) {
+    return ip[0] == value;
+}
+
+inline bool filter_first_second(const Ip& ip, int first, int second) {
+    return ip[0] == first && ip[1] == second;
+}
+
+inline bool filter_any(const Ip& ip, int value) {
+    return std::any_of(ip.begin(), ip.end(),
+        [value](int octet) { return octet == value; });
+}
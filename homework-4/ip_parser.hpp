@@ -0,0 +1,197 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define HOMEWORK4_HAVE_SSSE3 1
+#endif
+
+#include "packed_ip.hpp"
+
+// Разбор без std::string и потоков: адрес читается прямо из буфера.
+// Октет — от одной до трёх цифр со значением не больше 255, за адресом —
+// конец строки, '\t' или '\r'. Возвращается позиция сразу после адреса
+// или nullptr, если в начале [p, end) нет корректного адреса.
+inline const char* parse_ip_scalar(const char* p, const char* end, PackedIp& ip) {
+    PackedIp packed = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (i != 0) {
+            if (p == end || *p != '.') {
+                return nullptr;
+            }
+            ++p;
+        }
+        unsigned value = 0;
+        int digits = 0;
+        while (p != end && digits < 3 && *p >= '0' && *p <= '9') {
+            value = value * 10 + static_cast<unsigned>(*p - '0');
+            ++p;
+            ++digits;
+        }
+        if (digits == 0 || value > 255) {
+            return nullptr;
+        }
+        packed = (packed << 8) | value;
+    }
+    if (p != end && *p != '\t' && *p != '\r') {
+        return nullptr;
+    }
+    ip = packed;
+    return p;
+}
+
+#if defined(HOMEWORK4_HAVE_SSSE3)
+namespace detail {
+
+// Маски pshufb для всех 81 сочетаний длин октетов (1..3 цифры каждый):
+// октет k раскладывается в байты 4k..4k+2 как сотни, десятки, единицы,
+// недостающие старшие разряды и байт 4k+3 обнуляются (0x80).
+constexpr std::array<std::array<std::uint8_t, 16>, 81> make_shuffles() {
+    std::array<std::array<std::uint8_t, 16>, 81> table{};
+    for (std::size_t index = 0; index < table.size(); ++index) {
+        const std::size_t lengths[4] = {index / 27 + 1, index / 9 % 3 + 1, index / 3 % 3 + 1, index % 3 + 1};
+        std::size_t pos = 0;
+        for (std::size_t k = 0; k < 4; ++k) {
+            for (std::size_t j = 0; j < 3; ++j) {
+                const std::size_t skipped = 3 - lengths[k];
+                table[index][4 * k + j] = j < skipped ? 0x80 : static_cast<std::uint8_t>(pos + j - skipped);
+            }
+            table[index][4 * k + 3] = 0x80;
+            pos += lengths[k] + 1;
+        }
+    }
+    return table;
+}
+
+alignas(16) constexpr std::array<std::array<std::uint8_t, 16>, 81> kShuffles = make_shuffles();
+
+}  // namespace detail
+
+// То же за одну загрузку 16 байт: маски цифр и точек дают длину адреса и
+// позиции точек, pshufb раскладывает цифры по разрядам, pmaddubsw и
+// pmaddwd собирают октеты. Читает 16 байт от p, даже если end ближе, —
+// за буфером нужен запас. При nullptr ответ за parse_ip_scalar.
+inline const char* parse_ip_simd(const char* p, const char* end, PackedIp& ip) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i dots = _mm_cmpeq_epi8(v, _mm_set1_epi8('.'));
+    const __m128i digits = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                         _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    const unsigned run = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(dots, digits)));
+    const unsigned length = static_cast<unsigned>(__builtin_ctz(~run));
+    if (length == 16 || (p + length != end && p[length] != '\t' && p[length] != '\r')) {
+        return nullptr;
+    }
+
+    unsigned dot_mask = static_cast<unsigned>(_mm_movemask_epi8(dots)) & ((1u << length) - 1);
+    unsigned positions[3];
+    for (unsigned& position : positions) {
+        if (dot_mask == 0) {
+            return nullptr;
+        }
+        position = static_cast<unsigned>(__builtin_ctz(dot_mask));
+        dot_mask &= dot_mask - 1;
+    }
+    if (dot_mask != 0) {
+        return nullptr;
+    }
+    const unsigned lengths[4] = {positions[0], positions[1] - positions[0] - 1, positions[2] - positions[1] - 1,
+                                 length - positions[2] - 1};
+    unsigned index = 0;
+    for (unsigned octet_length : lengths) {
+        if (octet_length == 0 || octet_length > 3) {
+            return nullptr;
+        }
+        index = index * 3 + octet_length - 1;
+    }
+
+    const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(detail::kShuffles[index].data()));
+    const __m128i places = _mm_shuffle_epi8(_mm_sub_epi8(v, _mm_set1_epi8('0')), shuffle);
+    const __m128i pairs = _mm_maddubs_epi16(places, _mm_setr_epi8(100, 10, 1, 0, 100, 10, 1, 0,
+                                                                  100, 10, 1, 0, 100, 10, 1, 0));
+    const __m128i octets = _mm_madd_epi16(pairs, _mm_set1_epi16(1));
+    if (_mm_movemask_epi8(_mm_cmpgt_epi32(octets, _mm_set1_epi32(255))) != 0) {
+        return nullptr;
+    }
+    const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(octets, octets), _mm_setzero_si128());
+    const auto le = static_cast<std::uint32_t>(_mm_cvtsi128_si32(bytes));
+    ip = (le << 24) | ((le << 8) & 0xFF0000) | ((le >> 8) & 0xFF00) | (le >> 24);
+    return p + length;
+}
+#endif
+
+// Запас за концом данных в буфере: parse_ip_simd читает 16 байт.
+constexpr std::size_t kParsePadding = 16;
+
+// Адрес из начала строки [p, end); строка заканчивается перед '\n' или
+// концом данных, а за end есть kParsePadding доступных байт.
+inline PackedIp parse_line_ip(const char* p, const char* end, bool simd) {
+    PackedIp ip = 0;
+#if defined(HOMEWORK4_HAVE_SSSE3)
+    if (simd && parse_ip_simd(p, end, ip) != nullptr) {
+        return ip;
+    }
+#else
+    (void)simd;
+#endif
+    if (parse_ip_scalar(p, end, ip) == nullptr) {
+        throw std::runtime_error("Invalid IP format");
+    }
+    return ip;
+}
+
+// Читает поток блоками по kReadBlock байт через read(buffer, size) и
+// зовёт sink(ip) для первого поля каждой непустой строки. Строки не
+// копируются: разбор идёт прямо по буферу, незаконченная строка
+// переносится в его начало.
+template <typename Read, typename Sink>
+void for_each_ip(Read&& read, Sink&& sink, bool simd = true) {
+    constexpr std::size_t kReadBlock = 1 << 20;
+    std::vector<char> buffer(kReadBlock + kParsePadding);
+    std::size_t filled = 0;
+    bool eof = false;
+
+    while (!eof) {
+        if (filled == buffer.size() - kParsePadding) {
+            // Строка длиннее буфера.
+            buffer.resize(2 * buffer.size());
+        }
+        const std::size_t got = read(buffer.data() + filled, buffer.size() - kParsePadding - filled);
+        eof = got == 0;
+        filled += got;
+
+        char* data = buffer.data();
+        const char* end = data + filled;
+        std::memset(data + filled, 0, kParsePadding);
+        const char* p = data;
+        while (p != end) {
+            const auto* newline = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            if (newline == nullptr && !eof) {
+                break;
+            }
+            const char* line_end = newline != nullptr ? newline : end;
+            if (line_end != p) {
+                sink(parse_line_ip(p, line_end, simd));
+            }
+            p = newline != nullptr ? newline + 1 : end;
+        }
+        filled = static_cast<std::size_t>(end - p);
+        std::memmove(data, p, filled);
+    }
+}
+
+inline std::vector<PackedIp> read_packed_ips(std::FILE* in, bool simd = true) {
+    std::vector<PackedIp> ips;
+    for_each_ip([in](char* buffer, std::size_t size) { return std::fread(buffer, 1, size, in); },
+                [&ips](PackedIp ip) { ips.push_back(ip); }, simd);
+    if (std::ferror(in)) {
+        throw std::runtime_error("Failed to read input");
+    }
+    return ips;
+}
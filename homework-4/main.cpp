@@ -1,73 +1,76 @@
 #include <algorithm>
-#include <array>
-#include <cstddef>
+#include <cstdio>
+#include <functional>
 #include <iostream>
-#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
-namespace {
-
-using Ip = std::array<int, 4>;
+#include "filter_pipeline.hpp"
+#include "ip.hpp"
+#include "ip_parser.hpp"
+#include "packed_ip.hpp"
 
-constexpr int FILTER_FIRST_OCTET = 1;
-constexpr int FILTER_FIRST_OCTET_2 = 46;
-constexpr int FILTER_SECOND_OCTET_2 = 70;
-constexpr int FILTER_ANY_OCTET = 46;
-
-Ip parse_ip(const std::string& text) {
-    Ip ip{0, 0, 0, 0};
-    std::stringstream stream(text);
-    std::string part;
+namespace {
 
-    for (std::size_t i = 0; i < ip.size(); ++i) {
-        if (!std::getline(stream, part, '.')) {
-            throw std::runtime_error("Invalid IP format");
-        }
-        ip[i] = std::stoi(part);
+// array — исходный вариант (std::array<int, 4>, std::sort, вывод по
+// списку за проход), packed — uint32, radix sort и FilterPipeline. Вывод
+// у них одинаковый.
+enum class Engine {
+    Array,
+    Packed,
+};
+
+Engine parse_engine(const std::string& name) {
+    if (name == "array") {
+        return Engine::Array;
     }
-
-    return ip;
-}
-
-void print_ip(const Ip& ip) {
-    std::cout << ip[0] << '.'
-              << ip[1] << '.'
-              << ip[2] << '.'
-              << ip[3] << '\n';
+    if (name == "packed") {
+        return Engine::Packed;
+    }
+    throw std::runtime_error("Unknown --engine: " + name + " (expected array|packed)");
 }
 
-template <typename Predicate>
-void print_filtered(const std::vector<Ip>& ips, Predicate predicate) {
-    for (const Ip& ip : ips) {
-        if (predicate(ip)) {
-            print_ip(ip);
+struct Config {
+    Engine engine = Engine::Packed;
+    bool fast_parser = true;
+};
+
+Config parse_args(int argc, char* argv[]) {
+    Config cfg;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--engine") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --engine");
+            }
+            cfg.engine = parse_engine(argv[++i]);
+            continue;
+        }
+        if (arg == "--parser") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --parser");
+            }
+            const std::string parser = argv[++i];
+            if (parser != "fast" && parser != "stream") {
+                throw std::runtime_error("Unknown --parser: " + parser + " (expected fast|stream)");
+            }
+            cfg.fast_parser = parser == "fast";
+            continue;
         }
+        throw std::runtime_error(std::string("Usage: ") + argv[0] +
+                                 " [--engine array|packed] [--parser fast|stream] < ip_filter.tsv");
     }
+    return cfg;
 }
 
-bool filter_first(const Ip& ip, int value) {
-    return ip[0] == value;
-}
-
-bool filter_first_second(const Ip& ip, int first, int second) {
-    return ip[0] == first && ip[1] == second;
-}
-
-bool filter_any(const Ip& ip, int value) {
-    return std::any_of(ip.begin(), ip.end(),
-        [value](int octet) { return octet == value; });
-}
-
-} 
-
-int main() {
-    std::vector<Ip> ips;
+// Адреса из первого поля каждой строки stdin: std::getline и parse_ip
+// (исходный разбор, parser stream).
+template <typename Parse>
+auto read_ips(Parse parse) {
+    std::vector<decltype(parse(std::string()))> ips;
     std::string line;
 
-    std::cout << "Reading IP addresses from stdin (Ctrl+D to finish input)...\n";
-
     while (std::getline(std::cin, line)) {
         if (line.empty()) {
             continue;
@@ -76,26 +79,40 @@ int main() {
         const std::size_t tab_pos = line.find('\t');
         const std::string ip_text = line.substr(0, tab_pos);
 
-        ips.push_back(parse_ip(ip_text));
+        ips.push_back(parse(ip_text));
     }
+    return ips;
+}
 
-    std::sort(ips.begin(), ips.end(), std::greater<Ip>{});
-
-    print_filtered(ips, [](const Ip&) { return true; });
-
-    print_filtered(ips, [](const Ip& ip) {
-        return filter_first(ip, FILTER_FIRST_OCTET);
-    });
-
-    print_filtered(ips, [](const Ip& ip) {
-        return filter_first_second(ip,
-                                   FILTER_FIRST_OCTET_2,
-                                   FILTER_SECOND_OCTET_2);
-    });
-
-    print_filtered(ips, [](const Ip& ip) {
-        return filter_any(ip, FILTER_ANY_OCTET);
-    });
-
-    return 0;
-}
\ No newline at end of file
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const Config cfg = parse_args(argc, argv);
+
+        std::cout << "Reading IP addresses from stdin (Ctrl+D to finish input)...\n";
+
+        if (cfg.engine == Engine::Array) {
+            std::vector<Ip> ips;
+            if (cfg.fast_parser) {
+                for (PackedIp ip : read_packed_ips(stdin)) {
+                    ips.push_back(unpack_ip(ip));
+                }
+            } else {
+                ips = read_ips([](const std::string& text) { return parse_ip(text); });
+            }
+            std::sort(ips.begin(), ips.end(), std::greater<Ip>{});
+            print_report(ips);
+        } else {
+            std::vector<PackedIp> ips = cfg.fast_parser
+                ? read_packed_ips(stdin)
+                : read_ips([](const std::string& text) { return pack_ip(parse_ip(text)); });
+            radix_sort_descending(ips);
+            make_report_pipeline().run(ips, std::cout);
+        }
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "ip.hpp"
+
+// Адрес в одном uint32: первый октет — старший байт. Обратный
+// лексикографический порядок октетов — это просто убывание чисел, а
+// адрес занимает 4 байта вместо 16.
+using PackedIp = std::uint32_t;
+
+inline PackedIp pack_ip(const Ip& ip) {
+    PackedIp packed = 0;
+    for (int octet : ip) {
+        if (octet < 0 || octet > 255) {
+            throw std::runtime_error("Invalid IP format");
+        }
+        packed = (packed << 8) | static_cast<PackedIp>(octet);
+    }
+    return packed;
+}
+
+// Октет i (0 — первый).
+inline int octet(PackedIp ip, std::size_t i) {
+    return static_cast<int>((ip >> (24 - 8 * i)) & 0xFF);
+}
+
+inline Ip unpack_ip(PackedIp ip) {
+    return Ip{octet(ip, 0), octet(ip, 1), octet(ip, 2), octet(ip, 3)};
+}
+
+// LSD radix sort по убыванию: четыре прохода подсчётом по байту, от
+// младшего к старшему. Все гистограммы считаются за один проход;
+// байт, одинаковый у всех адресов, пропускается.
+inline void radix_sort_descending(std::vector<PackedIp>& ips) {
+    std::array<std::array<std::size_t, 256>, 4> counts{};
+    for (PackedIp ip : ips) {
+        for (std::size_t pass = 0; pass < 4; ++pass) {
+            ++counts[pass][(ip >> (8 * pass)) & 0xFF];
+        }
+    }
+
+    std::vector<PackedIp> buffer(ips.size());
+    for (std::size_t pass = 0; pass < 4; ++pass) {
+        const unsigned shift = static_cast<unsigned>(8 * pass);
+        std::array<std::size_t, 256>& offsets = counts[pass];
+        if (offsets[(ips.empty() ? 0 : ips.front() >> shift) & 0xFF] == ips.size()) {
+            continue;
+        }
+        // По убыванию: старшие значения байта идут первыми.
+        std::size_t total = 0;
+        for (std::size_t value = 256; value-- > 0;) {
+            const std::size_t count = offsets[value];
+            offsets[value] = total;
+            total += count;
+        }
+        for (PackedIp ip : ips) {
+            buffer[offsets[(ip >> shift) & 0xFF]++] = ip;
+        }
+        ips.swap(buffer);
+    }
+}
+
+inline void print_ip(PackedIp ip) {
+    std::cout << octet(ip, 0) << '.'
+              << octet(ip, 1) << '.'
+              << octet(ip, 2) << '.'
+              << octet(ip, 3) << '\n';
+}
+
+template <typename Predicate>
+void print_filtered(const std::vector<PackedIp>& ips, Predicate predicate) {
+    for (PackedIp ip : ips) {
+        if (predicate(ip)) {
+            print_ip(ip);
+        }
+    }
+}
+
+inline bool filter_first(PackedIp ip, int value) {
+    return static_cast<int>(ip >> 24) == value;
+}
+
+inline bool filter_first_second(PackedIp ip, int first, int second) {
+    return static_cast<int>(ip >> 16) == ((first << 8) | second);
+}
+
+inline bool filter_any(PackedIp ip, int value) {
+    for (std::size_t i = 0; i < 4; ++i) {
+        if (octet(ip, i) == value) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,1082 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "binary_format.hpp"
+#include "detector.hpp"
+#include "fast_reader.hpp"
+#include "incremental_detector.hpp"
+#include "projective_plane.hpp"
+#include "row_reader.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct BenchConfig {
+    std::string suite;
+    fs::path inputs;
+    fs::path file;
+    std::size_t rounds = 2000;
+    std::size_t repeat = 3;
+    std::size_t threads = 4;
+    std::size_t rows = 100000;
+    std::uint32_t seed = 42;
+};
+
+void print_usage(const char* prog) {
+    std::cout <<
+        "Usage: " << prog << " <suite> [options]\n"
+        "Suites:\n"
+        "  check             differential check of all engines on random matrices\n"
+        "                    (and on every file in --inputs DIR)\n"
+        "  engines           hash vs table vs bitset vs sparse vs auto on generated sparse and\n"
+        "                    dense cases\n"
+        "  count             count all 4-cycles: sparse vs bitset vs auto (on --threads threads)\n"
+        "  incremental       per-row latency of the incremental detector while the matrix grows\n"
+        "                    to --rows rows, and its snapshot save/load\n"
+        "  parse             istream vs fast reader (read() and mmap) vs binary bits/lists\n"
+        "                    (converted from --file) on --file, MB/s, and the full solve\n"
+        "                    with each of them\n"
+        "  threads           parallel table and bitset on cycle-free planes (and --file),\n"
+        "                    1, 2, 4, ... up to --threads\n"
+        "Options:\n"
+        "  --rounds R        random matrices for check (default: 2000)\n"
+        "  --repeat R        runs per variant, the best one is reported (default: 3)\n"
+        "  --threads N       max threads for check and threads, threads for count (default: 4)\n"
+        "  --rows N          incremental: rows to grow the matrix to (default: 100000)\n"
+        "  --seed S          random seed (default: 42)\n"
+        "  --inputs DIR      also run the engines on these input files\n"
+        "  --file FILE       parse: matrix in the text format (from homework_6_generator)\n"
+        "\nExample:\n"
+        "  " << prog << " check --inputs inputs\n"
+        "  homework_6_generator 200000 200000 0 42 > max.txt\n"
+        "  " << prog << " parse --file max.txt\n"
+        "  " << prog << " threads --threads 8 --file max.txt\n";
+}
+
+BenchConfig parse_args(int argc, char* argv[]) {
+    BenchConfig cfg;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto need = [&](const char* name) -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error(std::string("Missing value for ") + name);
+            }
+            return argv[++i];
+        };
+        if (arg == "--rounds") {
+            cfg.rounds = static_cast<std::size_t>(std::stoul(need("--rounds")));
+        } else if (arg == "--repeat") {
+            cfg.repeat = static_cast<std::size_t>(std::stoul(need("--repeat")));
+        } else if (arg == "--threads") {
+            cfg.threads = static_cast<std::size_t>(std::stoul(need("--threads")));
+        } else if (arg == "--rows") {
+            cfg.rows = static_cast<std::size_t>(std::stoul(need("--rows")));
+        } else if (arg == "--seed") {
+            cfg.seed = static_cast<std::uint32_t>(std::stoul(need("--seed")));
+        } else if (arg == "--inputs") {
+            cfg.inputs = need("--inputs");
+        } else if (arg == "--file") {
+            cfg.file = need("--file");
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() != 1 || cfg.repeat == 0 || cfg.threads == 0 || cfg.rows == 0) {
+        print_usage(argv[0]);
+        throw std::runtime_error("Invalid arguments");
+    }
+    cfg.suite = positional[0];
+    return cfg;
+}
+
+// Матрица в памяти: строки списками столбцов.
+struct Matrix {
+    std::size_t rows = 0;
+    std::size_t cols = 0;
+    std::vector<std::vector<std::uint32_t>> ones;
+};
+
+// Тот же интерфейс, что у TextRowReader, но без разбора текста.
+class MatrixRowReader {
+public:
+    explicit MatrixRowReader(const Matrix& matrix) : matrix_(matrix) {}
+
+    std::size_t rows() const {
+        return matrix_.rows;
+    }
+
+    std::size_t cols() const {
+        return matrix_.cols;
+    }
+
+    bool next(std::vector<std::uint32_t>& ones) {
+        if (next_ == matrix_.ones.size()) {
+            return false;
+        }
+        ones = matrix_.ones[next_++];
+        return true;
+    }
+
+private:
+    const Matrix& matrix_;
+    std::size_t next_ = 0;
+};
+
+// Случайная матрица с вероятностью единицы density. Для разреженных
+// матриц позиции единиц берутся геометрическими скачками, а не по клеткам.
+Matrix random_matrix(std::size_t rows, std::size_t cols, double density, std::mt19937& rng) {
+    Matrix matrix{rows, cols, std::vector<std::vector<std::uint32_t>>(rows)};
+    if (density <= 0.0) {
+        return matrix;
+    }
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::geometric_distribution<std::size_t> gap(std::min(density, 1.0 - 1e-12));
+    for (auto& row : matrix.ones) {
+        for (std::size_t c = density >= 1.0 ? 0 : gap(rng); c < cols; c += density >= 1.0 ? 1 : gap(rng) + 1) {
+            row.push_back(static_cast<std::uint32_t>(c));
+        }
+    }
+    return matrix;
+}
+
+void inject_cycle(Matrix& matrix, std::mt19937& rng) {
+    if (matrix.rows < 2 || matrix.cols < 2) {
+        return;
+    }
+    std::uniform_int_distribution<std::size_t> row_dist(0, matrix.rows - 1);
+    std::uniform_int_distribution<std::uint32_t> col_dist(0, static_cast<std::uint32_t>(matrix.cols - 1));
+    const std::size_t r1 = row_dist(rng);
+    std::size_t r2 = row_dist(rng);
+    while (r2 == r1) {
+        r2 = row_dist(rng);
+    }
+    const std::uint32_t c1 = col_dist(rng);
+    std::uint32_t c2 = col_dist(rng);
+    while (c2 == c1) {
+        c2 = col_dist(rng);
+    }
+    for (std::size_t r : {r1, r2}) {
+        auto& row = matrix.ones[r];
+        row.push_back(c1);
+        row.push_back(c2);
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+    }
+}
+
+Matrix load_matrix(const fs::path& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open file: " + path.string());
+    }
+    TextRowReader reader(file);
+    Matrix matrix{reader.rows(), reader.cols(), {}};
+    std::vector<std::uint32_t> ones;
+    while (reader.next(ones)) {
+        matrix.ones.push_back(ones);
+    }
+    return matrix;
+}
+
+std::vector<fs::path> list_inputs(const fs::path& dir) {
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (entry.is_regular_file()) {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// Эталон для маленьких матриц: пересечение каждой пары строк.
+bool brute_force(const Matrix& matrix) {
+    for (std::size_t i = 0; i < matrix.rows; ++i) {
+        for (std::size_t j = i + 1; j < matrix.rows; ++j) {
+            std::vector<std::uint32_t> common;
+            std::set_intersection(matrix.ones[i].begin(), matrix.ones[i].end(),
+                                  matrix.ones[j].begin(), matrix.ones[j].end(),
+                                  std::back_inserter(common));
+            if (common.size() >= 2) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Эталон подсчёта: C(общих столбцов, 2) по всем парам строк.
+CycleCount brute_force_count(const Matrix& matrix) {
+    CycleCount total = 0;
+    for (std::size_t i = 0; i < matrix.rows; ++i) {
+        for (std::size_t j = i + 1; j < matrix.rows; ++j) {
+            std::vector<std::uint32_t> common;
+            std::set_intersection(matrix.ones[i].begin(), matrix.ones[i].end(),
+                                  matrix.ones[j].begin(), matrix.ones[j].end(),
+                                  std::back_inserter(common));
+            total += choose_2(common.size());
+        }
+    }
+    return total;
+}
+
+// Первая строка, которая замыкает цикл с одной из прежних; rows — цикла нет.
+// На ней должен останавливаться любой последовательный движок.
+std::size_t brute_force_closing_row(const Matrix& matrix) {
+    for (std::size_t j = 1; j < matrix.rows; ++j) {
+        for (std::size_t i = 0; i < j; ++i) {
+            std::vector<std::uint32_t> common;
+            std::set_intersection(matrix.ones[i].begin(), matrix.ones[i].end(),
+                                  matrix.ones[j].begin(), matrix.ones[j].end(),
+                                  std::back_inserter(common));
+            if (common.size() >= 2) {
+                return j;
+            }
+        }
+    }
+    return matrix.rows;
+}
+
+bool valid_cycle(const Matrix& matrix, const Cycle& cycle) {
+    auto has_one = [&](std::uint64_t row, std::uint32_t col) {
+        const auto& ones = matrix.ones[row];
+        return std::binary_search(ones.begin(), ones.end(), col);
+    };
+    return cycle.r1 < cycle.r2 && cycle.r2 < matrix.rows && cycle.c1 < cycle.c2 && has_one(cycle.r1, cycle.c1) &&
+           has_one(cycle.r1, cycle.c2) && has_one(cycle.r2, cycle.c1) && has_one(cycle.r2, cycle.c2);
+}
+
+bool run_engine(const Matrix& matrix,
+                Engine engine,
+                Engine* used = nullptr,
+                std::size_t threads = 1,
+                Cycle* witness = nullptr) {
+    MatrixRowReader reader(matrix);
+    return has_cycle_4(reader, engine, used, threads, witness);
+}
+
+CycleCount run_counter(const Matrix& matrix, Engine engine, Engine* used = nullptr, std::size_t threads = 1) {
+    MatrixRowReader reader(matrix);
+    return count_cycles_4(reader, engine, used, threads);
+}
+
+// Таблица пар без оценки размера: всегда хеш-таблица с ростом от
+// минимальной ёмкости, а не битовая карта.
+bool run_growing_table(const Matrix& matrix) {
+    PairTableDetector detector(matrix.cols, 0);
+    for (const auto& row : matrix.ones) {
+        if (detector.add_row(row.data(), row.size())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::vector<Engine> kEngines = {Engine::Hash, Engine::Table, Engine::Bitset, Engine::Sparse, Engine::Auto};
+const std::vector<Engine> kParallelEngines = {Engine::Table, Engine::Bitset, Engine::Sparse};
+const std::vector<Engine> kCounters = {Engine::Sparse, Engine::Bitset, Engine::Auto};
+
+// Параллельные варианты на 2..max_threads потоках против ответа expected.
+std::size_t check_parallel(const Matrix& matrix, bool expected, std::size_t max_threads) {
+    std::size_t failures = 0;
+    for (std::size_t threads = 2; threads <= max_threads; ++threads) {
+        for (Engine engine : kParallelEngines) {
+            failures += run_engine(matrix, engine, nullptr, threads) != expected ? 1 : 0;
+        }
+    }
+    return failures;
+}
+
+// Witness всех движков и подсчёт циклов против перебора. Последовательный
+// движок останавливается на первой замыкающей строке, параллельный — на
+// любой.
+std::size_t check_witness_and_count(const Matrix& matrix, std::size_t max_threads) {
+    const std::size_t closing_row = brute_force_closing_row(matrix);
+    const bool expected = closing_row < matrix.rows;
+    std::size_t failures = 0;
+    for (std::size_t threads = 1; threads <= max_threads; ++threads) {
+        for (Engine engine : threads == 1 ? kEngines : kParallelEngines) {
+            Cycle cycle;
+            const bool found = run_engine(matrix, engine, nullptr, threads, &cycle);
+            const bool ok = found == expected &&
+                            (!found || (valid_cycle(matrix, cycle) && (threads > 1 || cycle.r2 == closing_row)));
+            failures += ok ? 0 : 1;
+        }
+    }
+
+    const CycleCount cycles = brute_force_count(matrix);
+    for (std::size_t threads = 1; threads <= max_threads; ++threads) {
+        for (Engine engine : kCounters) {
+            failures += run_counter(matrix, engine, nullptr, threads) != cycles ? 1 : 0;
+        }
+    }
+    return failures;
+}
+
+// Все строки матрицы или текст ошибки — для сравнения разборщиков.
+template <typename Reader>
+std::string dump_rows(Reader& reader) {
+    std::string out = std::to_string(reader.rows()) + 'x' + std::to_string(reader.cols()) + '\n';
+    std::vector<std::uint32_t> ones;
+    try {
+        while (reader.next(ones)) {
+            for (std::uint32_t c : ones) {
+                out += std::to_string(c) + ' ';
+            }
+            out += '\n';
+        }
+    } catch (const std::exception& ex) {
+        out += std::string("error: ") + ex.what();
+    }
+    return out;
+}
+
+// dump_rows с ошибкой ещё в заголовке.
+template <typename Dump>
+std::string guarded(Dump&& dump) {
+    try {
+        return dump();
+    } catch (const std::exception& ex) {
+        return std::string("error: ") + ex.what();
+    }
+}
+
+// Текст матрицы с произвольными разделителями, «нулями» не только из '0'
+// и иногда испорченный: обрезанный, с пробелом внутри строки, с лишним
+// символом в строке.
+std::string random_text(const Matrix& matrix, std::mt19937& rng) {
+    static const char* separators[] = {"\n", "\r\n", " ", "\t\n", "\n\n", "\n\v \f"};
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<std::size_t> separator(0, std::size(separators) - 1);
+    std::string text = (percent(rng) < 20 ? "  " : "") + std::to_string(matrix.rows) + ' ' +
+                       std::to_string(matrix.cols) + separators[separator(rng)];
+    for (const auto& row : matrix.ones) {
+        std::string line(matrix.cols, '0');
+        for (std::uint32_t c : row) {
+            line[c] = '1';
+        }
+        if (percent(rng) < 5) {
+            line[std::uniform_int_distribution<std::size_t>(0, line.size() - 1)(rng)] = 'x';
+        }
+        text += line + separators[separator(rng)];
+    }
+    const int damage = percent(rng);
+    if (damage < 10 && !text.empty()) {
+        text.resize(std::uniform_int_distribution<std::size_t>(0, text.size() - 1)(rng));
+    } else if (damage < 15) {
+        text.insert(text.size() / 2, " ");
+    } else if (damage < 20) {
+        text.insert(text.size() / 2, "1");
+    }
+    return text;
+}
+
+// Быстрый разборщик (mmap и read()) против построчного istream.
+std::size_t check_parsers(std::size_t rounds, std::mt19937& rng) {
+    std::uniform_int_distribution<std::size_t> size_dist(1, 80);
+    std::uniform_real_distribution<double> density_dist(0.0, 1.0);
+    const fs::path path = fs::temp_directory_path() / ("homework_6_bench_" + std::to_string(::getpid()) + ".txt");
+    std::size_t failures = 0;
+    std::size_t errors = 0;
+    for (std::size_t round = 0; round < rounds; ++round) {
+        const Matrix matrix = random_matrix(size_dist(rng), size_dist(rng), density_dist(rng), rng);
+        {
+            std::ofstream out(path, std::ios::binary);
+            out << random_text(matrix, rng);
+        }
+        const std::string expected = guarded([&] {
+            std::ifstream file(path, std::ios::binary);
+            TextRowReader reader(file);
+            return dump_rows(reader);
+        });
+        errors += expected.find("error: ") != std::string::npos ? 1 : 0;
+        for (bool mmap : {true, false}) {
+            const std::string got = guarded([&] {
+                FastRowReader reader(path.string(), mmap);
+                return dump_rows(reader);
+            });
+            if (got != expected) {
+                std::cerr << "Parser mismatch: round " << round << (mmap ? ", mmap" : ", read") << '\n';
+                ++failures;
+            }
+        }
+    }
+    fs::remove(path);
+    std::cout << "parsers: " << rounds << " texts, " << errors << " malformed, " << failures << " mismatches\n";
+    return failures;
+}
+
+void write_binary(const Matrix& matrix, BinaryLayout layout, const fs::path& path) {
+    std::ofstream out(path, std::ios::binary);
+    BinaryRowWriter writer(out, layout, matrix.rows, matrix.cols);
+    for (const auto& row : matrix.ones) {
+        writer.add_row(row.data(), row.size());
+    }
+    writer.finish();
+}
+
+// Двоичный формат: запись и чтение (mmap и read()) возвращают ту же
+// матрицу; обрезанный файл — ошибка, а не мусор.
+std::size_t check_binary(std::size_t rounds, std::mt19937& rng) {
+    std::uniform_int_distribution<std::size_t> size_dist(1, 200);
+    std::uniform_real_distribution<double> density_dist(0.0, 1.0);
+    std::uniform_int_distribution<int> percent(0, 99);
+    const fs::path path = fs::temp_directory_path() / ("homework_6_bench_" + std::to_string(::getpid()) + ".bin");
+    std::size_t failures = 0;
+    std::size_t truncated = 0;
+    for (std::size_t round = 0; round < rounds; ++round) {
+        const Matrix matrix = random_matrix(size_dist(rng), size_dist(rng), density_dist(rng), rng);
+        const std::string expected = guarded([&] {
+            MatrixRowReader reader(matrix);
+            return dump_rows(reader);
+        });
+        for (BinaryLayout layout : {BinaryLayout::Bits, BinaryLayout::Lists}) {
+            write_binary(matrix, layout, path);
+            const bool truncate = percent(rng) < 10;
+            if (truncate) {
+                fs::resize_file(path, std::uniform_int_distribution<std::uintmax_t>(0, fs::file_size(path) - 1)(rng));
+                ++truncated;
+            }
+            for (bool mmap : {true, false}) {
+                const std::string got = guarded([&] {
+                    BinaryRowReader reader(path.string(), mmap);
+                    return dump_rows(reader);
+                });
+                const bool ok = truncate ? got.find("error: ") != std::string::npos : got == expected;
+                if (!ok) {
+                    std::cerr << "Binary mismatch: round " << round << ", " << layout_name(layout)
+                              << (mmap ? ", mmap" : ", read") << '\n';
+                    ++failures;
+                }
+            }
+        }
+    }
+    fs::remove(path);
+    std::cout << "binary: " << rounds << " matrices, " << truncated << " truncated files, " << failures
+              << " mismatches\n";
+    return failures;
+}
+
+// Инкрементальный детектор: ответ для каждой строки против перебора и то
+// же после сохранения и загрузки снимка посреди матрицы.
+std::size_t check_incremental(std::size_t rounds, std::mt19937& rng) {
+    std::uniform_int_distribution<std::size_t> size_dist(1, 100);
+    std::uniform_real_distribution<double> density_dist(0.0, 1.0);
+    const fs::path path = fs::temp_directory_path() / ("homework_6_bench_" + std::to_string(::getpid()) + ".state");
+    std::size_t failures = 0;
+    for (std::size_t round = 0; round < rounds; ++round) {
+        const Matrix matrix = random_matrix(size_dist(rng), size_dist(rng), std::pow(density_dist(rng), 3), rng);
+        const std::size_t snapshot_row = std::uniform_int_distribution<std::size_t>(0, matrix.rows)(rng);
+        IncrementalDetector detector(matrix.cols);
+        std::size_t first_closing = matrix.rows;
+        for (std::size_t r = 0; r < matrix.rows; ++r) {
+            if (r == snapshot_row) {
+                detector.save(path.string());
+                detector = IncrementalDetector::load(path.string());
+            }
+            bool expected = false;
+            for (std::size_t i = 0; i < r && !expected; ++i) {
+                std::vector<std::uint32_t> common;
+                std::set_intersection(matrix.ones[i].begin(), matrix.ones[i].end(), matrix.ones[r].begin(),
+                                      matrix.ones[r].end(), std::back_inserter(common));
+                expected = common.size() >= 2;
+            }
+            const bool closes = detector.add_row(matrix.ones[r]);
+            bool ok = closes == expected && (!closes || (valid_cycle(matrix, detector.cycle()) &&
+                                                         detector.cycle().r2 == r));
+            if (closes && first_closing == matrix.rows) {
+                first_closing = r;
+            }
+            if (!ok) {
+                std::cerr << "Incremental mismatch: round " << round << ", row " << r << '\n';
+                ++failures;
+                break;
+            }
+        }
+        if (detector.has_cycle() != (first_closing < matrix.rows) ||
+            (detector.has_cycle() && detector.first_cycle().r2 != first_closing)) {
+            std::cerr << "Incremental mismatch: round " << round << ", first cycle\n";
+            ++failures;
+        }
+    }
+    fs::remove(path);
+    std::cout << "incremental: " << rounds << " matrices, " << failures << " mismatches\n";
+    return failures;
+}
+
+int bench_check(const BenchConfig& cfg) {
+    std::mt19937 rng(cfg.seed);
+    std::uniform_int_distribution<std::size_t> size_dist(1, 150);
+    std::uniform_real_distribution<double> density_dist(0.0, 1.0);
+    std::size_t cycles = 0;
+    std::size_t failures = 0;
+
+    for (std::size_t round = 0; round < cfg.rounds; ++round) {
+        // Каждая вторая матрица — широкая, чтобы задеть векторные ветки.
+        const std::size_t rows = size_dist(rng);
+        const std::size_t cols = size_dist(rng) * (round % 2 == 0 ? 1 : 20);
+        // Плотность в четвёртой степени: больше разреженных матриц, где ответ бывает 0.
+        const double density = std::pow(density_dist(rng), 4);
+        Matrix matrix = random_matrix(rows, cols, density, rng);
+        if (round % 4 == 0) {
+            inject_cycle(matrix, rng);
+        }
+
+        const bool expected = brute_force(matrix);
+        cycles += expected ? 1 : 0;
+        for (Engine engine : kEngines) {
+            if (run_engine(matrix, engine) != expected) {
+                std::cerr << "Mismatch: round " << round << ", " << rows << 'x' << cols
+                          << ", density " << density << ", engine " << engine_name(engine) << '\n';
+                ++failures;
+            }
+        }
+        if (run_growing_table(matrix) != expected) {
+            std::cerr << "Mismatch: round " << round << ", growing table\n";
+            ++failures;
+        }
+        if (check_parallel(matrix, expected, cfg.threads) != 0) {
+            std::cerr << "Mismatch: round " << round << ", parallel\n";
+            ++failures;
+        }
+        if (check_witness_and_count(matrix, cfg.threads) != 0) {
+            std::cerr << "Mismatch: round " << round << ", witness or count\n";
+            ++failures;
+        }
+    }
+    std::cout << "random: " << cfg.rounds << " matrices, " << cycles << " with a cycle, "
+              << failures << " mismatches\n";
+
+    // Проективные плоскости: циклов нет, пары столбцов ровно C(M, 2).
+    // После добавления одной единицы цикл обязан появиться.
+    for (std::uint32_t q : {2u, 3u, 5u, 7u, 11u, 13u}) {
+        const std::vector<std::vector<std::uint32_t>> lines = projective_plane(q);
+        Matrix matrix{lines.size(), lines.size(), lines};
+        std::size_t plane_failures = brute_force(matrix) ? 1 : 0;
+        for (const auto& row : matrix.ones) {
+            plane_failures += row.size() != q + 1 ? 1 : 0;
+        }
+        for (int extra = 0; extra < 2; ++extra) {
+            for (Engine engine : kEngines) {
+                plane_failures += run_engine(matrix, engine) != (extra == 1) ? 1 : 0;
+            }
+            plane_failures += run_growing_table(matrix) != (extra == 1) ? 1 : 0;
+            plane_failures += check_parallel(matrix, extra == 1, cfg.threads);
+            plane_failures += check_witness_and_count(matrix, cfg.threads);
+            auto& row = matrix.ones.back();
+            const auto missing = static_cast<std::uint32_t>(
+                std::find(row.begin(), row.end(), 0u) == row.end() ? 0 : matrix.cols - 1);
+            row.insert(std::lower_bound(row.begin(), row.end(), missing), missing);
+        }
+        std::cout << "plane q=" << q << ": " << matrix.rows << 'x' << matrix.cols << ", "
+                  << plane_failures << " mismatches\n";
+        failures += plane_failures;
+    }
+
+    if (!cfg.inputs.empty()) {
+        for (const auto& path : list_inputs(cfg.inputs)) {
+            const Matrix matrix = load_matrix(path);
+            const bool expected = brute_force(matrix);
+            std::cout << path.filename().string() << ' ' << expected;
+            for (Engine engine : kEngines) {
+                const bool found = run_engine(matrix, engine);
+                std::cout << ' ' << engine_name(engine) << '=' << found;
+                failures += found != expected ? 1 : 0;
+            }
+            failures += check_parallel(matrix, expected, cfg.threads);
+            failures += check_witness_and_count(matrix, cfg.threads);
+            std::cout << '\n';
+        }
+    }
+
+    failures += check_parsers(cfg.rounds, rng);
+    failures += check_binary(cfg.rounds, rng);
+    failures += check_incremental(cfg.rounds, rng);
+
+    if (failures != 0) {
+        std::cerr << "Error: engines or parsers disagree with the reference\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Лучшее время из repeat прогонов, в секундах.
+double best_of(std::size_t repeat, const std::function<void()>& run) {
+    double best = 0.0;
+    for (std::size_t i = 0; i < repeat; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+bool contains(const std::vector<Engine>& engines, Engine engine) {
+    return std::find(engines.begin(), engines.end(), engine) != engines.end();
+}
+
+int bench_engines(const BenchConfig& cfg) {
+    struct Case {
+        std::string name;
+        Matrix matrix;
+        std::vector<Engine> skip;  // варианты, которые на этом случае идут минутами
+    };
+    std::mt19937 rng(cfg.seed);
+    auto plane = [](std::uint32_t q) {
+        std::vector<std::vector<std::uint32_t>> lines = projective_plane(q);
+        const std::size_t size = lines.size();
+        return Matrix{size, size, std::move(lines)};
+    };
+    std::vector<Case> cases = {
+        {"sparse 20000^2", random_matrix(20000, 20000, 0.0001, rng), {}},
+        {"sparse 200000^2", random_matrix(200000, 200000, 0.00001, rng), {Engine::Bitset}},
+        {"medium 3000^2", random_matrix(3000, 3000, 0.01, rng), {}},
+        {"dense 2000^2", random_matrix(2000, 2000, 0.5, rng), {}},
+        {"dense 200x20000", random_matrix(200, 20000, 0.3, rng), {}},
+        {"row-dense 20x4000", random_matrix(20, 4000, 0.9, rng), {}},
+        {"plane q=31", plane(31), {}},
+        {"plane q=61", plane(61), {}},
+        {"plane q=127", plane(127), {Engine::Hash, Engine::Bitset}},
+    };
+    if (!cfg.inputs.empty()) {
+        for (const auto& path : list_inputs(cfg.inputs)) {
+            cases.push_back({"inputs/" + path.filename().string(), load_matrix(path), {}});
+        }
+    }
+
+    std::cout << std::left << std::setw(20) << "case" << std::right << std::setw(8) << "answer";
+    for (Engine engine : kEngines) {
+        std::cout << std::setw(12) << engine_name(engine);
+    }
+    std::cout << "  auto picks\n";
+
+    int status = 0;
+    for (const Case& c : cases) {
+        int answer = -1;
+        Engine picked = Engine::Auto;
+        std::vector<double> times;
+        for (Engine engine : kEngines) {
+            if (contains(c.skip, engine)) {
+                times.push_back(-1.0);
+                continue;
+            }
+            bool found = false;
+            times.push_back(best_of(cfg.repeat, [&] {
+                found = run_engine(c.matrix, engine, &picked);
+            }));
+            if (answer >= 0 && answer != static_cast<int>(found)) {
+                status = 1;
+            }
+            answer = found ? 1 : 0;
+        }
+        std::cout << std::left << std::setw(20) << c.name << std::right << std::setw(8) << answer;
+        for (double seconds : times) {
+            if (seconds < 0) {
+                std::cout << std::setw(12) << "-";
+            } else {
+                std::cout << std::setw(9) << std::fixed << std::setprecision(3) << seconds * 1000 << " ms";
+            }
+        }
+        std::cout << "  " << engine_name(picked) << std::endl;
+    }
+    if (status != 0) {
+        std::cerr << "Error: engines disagree\n";
+    }
+    return status;
+}
+
+// Подсчёт всех циклов: sparse против bitset и выбор auto. Ответы всех
+// вариантов должны совпасть.
+int bench_count(const BenchConfig& cfg) {
+    struct Case {
+        std::string name;
+        Matrix matrix;
+        std::vector<Engine> skip;
+    };
+    std::mt19937 rng(cfg.seed);
+    auto plane = [](std::uint32_t q) {
+        std::vector<std::vector<std::uint32_t>> lines = projective_plane(q);
+        const std::size_t size = lines.size();
+        return Matrix{size, size, std::move(lines)};
+    };
+    std::vector<Case> cases = {
+        {"sparse 200000^2", random_matrix(200000, 200000, 0.00001, rng), {Engine::Bitset}},
+        {"sparse 20000^2", random_matrix(20000, 20000, 0.001, rng), {Engine::Bitset}},
+        {"medium 3000^2", random_matrix(3000, 3000, 0.01, rng), {}},
+        {"dense 1000^2", random_matrix(1000, 1000, 0.5, rng), {}},
+        {"dense 200x20000", random_matrix(200, 20000, 0.3, rng), {}},
+        {"plane q=61", plane(61), {}},
+        {"plane q=127", plane(127), {Engine::Bitset}},
+    };
+    if (!cfg.inputs.empty()) {
+        for (const auto& path : list_inputs(cfg.inputs)) {
+            cases.push_back({"inputs/" + path.filename().string(), load_matrix(path), {}});
+        }
+    }
+
+    std::cout << std::left << std::setw(20) << "case" << std::right << std::setw(24) << "cycles";
+    for (Engine engine : kCounters) {
+        std::cout << std::setw(12) << engine_name(engine);
+    }
+    std::cout << "  auto picks\n";
+
+    int status = 0;
+    for (const Case& c : cases) {
+        std::string answer;
+        Engine picked = Engine::Auto;
+        std::vector<double> times;
+        for (Engine engine : kCounters) {
+            if (contains(c.skip, engine)) {
+                times.push_back(-1.0);
+                continue;
+            }
+            CycleCount cycles = 0;
+            times.push_back(best_of(cfg.repeat, [&] {
+                cycles = run_counter(c.matrix, engine, &picked, cfg.threads);
+            }));
+            if (!answer.empty() && answer != to_string(cycles)) {
+                status = 1;
+            }
+            answer = to_string(cycles);
+        }
+        std::cout << std::left << std::setw(20) << c.name << std::right << std::setw(24) << answer;
+        for (double seconds : times) {
+            if (seconds < 0) {
+                std::cout << std::setw(12) << "-";
+            } else {
+                std::cout << std::setw(9) << std::fixed << std::setprecision(3) << seconds * 1000 << " ms";
+            }
+        }
+        std::cout << "  " << engine_name(picked) << std::endl;
+    }
+    if (status != 0) {
+        std::cerr << "Error: counters disagree\n";
+    }
+    return status;
+}
+
+void print_row(const std::string& name, double seconds, std::uint64_t bytes, const std::string& note) {
+    const double mb = static_cast<double>(bytes) / 1e6;
+    std::cout << std::left << std::setw(16) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(3) << seconds << " s"
+              << std::setw(12) << std::setprecision(1) << mb / seconds << " MB/s"
+              << "  " << note << std::endl;
+}
+
+// Прочитать все строки: число единиц и контрольная сумма номеров столбцов.
+template <typename Reader>
+std::string drain(Reader& reader) {
+    std::vector<std::uint32_t> ones;
+    std::uint64_t count = 0;
+    std::uint64_t checksum = 0;
+    std::uint64_t row = 0;
+    while (reader.next(ones)) {
+        ++row;
+        count += ones.size();
+        for (std::uint32_t c : ones) {
+            checksum = checksum * 31 + c + row;
+        }
+    }
+    return std::to_string(row) + " rows, " + std::to_string(count) + " ones, checksum " + std::to_string(checksum);
+}
+
+int bench_parse(const BenchConfig& cfg) {
+    if (cfg.file.empty()) {
+        throw std::runtime_error("parse needs --file");
+    }
+    const std::uint64_t bytes = fs::file_size(cfg.file);
+    std::cout << "File: " << cfg.file.string() << ", " << bytes / (1024 * 1024) << " MiB\n";
+
+    // Та же матрица в двоичном формате, без замера. MB/s у двоичных
+    // вариантов — от размера их собственного файла.
+    const std::string stem = (fs::temp_directory_path() / ("homework_6_bench_" + std::to_string(::getpid()))).string();
+    const std::string bits_file = stem + ".bits";
+    const std::string lists_file = stem + ".lists";
+    const std::pair<BinaryLayout, std::string> binaries[] = {{BinaryLayout::Bits, bits_file},
+                                                             {BinaryLayout::Lists, lists_file}};
+    for (const auto& [layout, path] : binaries) {
+        FastRowReader reader(cfg.file.string());
+        std::ofstream out(path, std::ios::binary);
+        BinaryRowWriter writer(out, layout, reader.rows(), reader.cols());
+        std::vector<std::uint32_t> ones;
+        while (reader.next(ones)) {
+            writer.add_row(ones.data(), ones.size());
+        }
+        writer.finish();
+    }
+    const std::uint64_t bits_bytes = fs::file_size(bits_file);
+    const std::uint64_t lists_bytes = fs::file_size(lists_file);
+    std::cout << "Binary: bits " << bits_bytes / (1024 * 1024) << " MiB, lists " << lists_bytes / (1024 * 1024)
+              << " MiB\n";
+
+    std::vector<std::string> drains;
+    std::vector<std::string> answers;
+    auto run_with = [&](std::vector<std::string>& notes, const std::string& name, std::uint64_t size,
+                        const std::function<std::string()>& run) {
+        std::string note;
+        const double seconds = best_of(cfg.repeat, [&] {
+            note = run();
+        });
+        print_row(name, seconds, size, note);
+        notes.push_back(note);
+    };
+    auto drain_with = [&](const std::string& name, const std::function<std::string()>& run) {
+        run_with(drains, name, bytes, run);
+    };
+    drain_with("istream", [&] {
+        std::ifstream file(cfg.file);
+        TextRowReader reader(file);
+        return drain(reader);
+    });
+    drain_with("fast/read", [&] {
+        FastRowReader reader(cfg.file.string(), false);
+        return drain(reader);
+    });
+    drain_with("fast/mmap", [&] {
+        FastRowReader reader(cfg.file.string(), true);
+        return drain(reader);
+    });
+    run_with(drains, "bits/mmap", bits_bytes, [&] {
+        BinaryRowReader reader(bits_file);
+        return drain(reader);
+    });
+    run_with(drains, "lists/mmap", lists_bytes, [&] {
+        BinaryRowReader reader(lists_file);
+        return drain(reader);
+    });
+
+    // Полное решение: разбор и поиск цикла вместе (у fast — параллельно).
+    Engine used = Engine::Auto;
+    auto solve_with = [&](const std::string& name, std::uint64_t size, auto make_reader) {
+        run_with(answers, name, size, [&] {
+            auto reader = make_reader();
+            const bool found = has_cycle_4(*reader, Engine::Auto, &used);
+            return std::string("answer ") + (found ? "1" : "0") + ", " + engine_name(used);
+        });
+    };
+    std::ifstream text;
+    solve_with("solve/istream", bytes, [&] {
+        text = std::ifstream(cfg.file);
+        return std::make_unique<TextRowReader>(text);
+    });
+    solve_with("solve/fast", bytes, [&] {
+        return std::make_unique<FastRowReader>(cfg.file.string());
+    });
+    solve_with("solve/bits", bits_bytes, [&] {
+        return std::make_unique<BinaryRowReader>(bits_file);
+    });
+    solve_with("solve/lists", lists_bytes, [&] {
+        return std::make_unique<BinaryRowReader>(lists_file);
+    });
+    fs::remove(bits_file);
+    fs::remove(lists_file);
+
+    const bool agree = std::all_of(drains.begin(), drains.end(), [&](const std::string& note) {
+        return note == drains.front();
+    }) && std::all_of(answers.begin(), answers.end(), [&](const std::string& note) {
+        return note == answers.front();
+    });
+    if (!agree) {
+        std::cerr << "Error: readers disagree\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Масштабирование по потокам на худших случаях — без цикла, когда
+// досрочного выхода нет и каждая строка проверяется целиком.
+int bench_threads(const BenchConfig& cfg) {
+    std::vector<std::size_t> counts;
+    for (std::size_t threads = 1; threads < cfg.threads; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(cfg.threads);
+
+    std::cout << std::left << std::setw(20) << "case" << std::setw(8) << "engine" << std::right << std::setw(8)
+              << "answer";
+    for (std::size_t threads : counts) {
+        std::cout << std::setw(13) << threads << 't';
+    }
+    std::cout << '\n';
+
+    int status = 0;
+    auto run_case = [&](const std::string& name, Engine engine, const std::function<bool(std::size_t)>& solve) {
+        std::cout << std::left << std::setw(20) << name << std::setw(8) << engine_name(engine) << std::flush;
+        int answer = -1;
+        std::vector<double> times;
+        for (std::size_t threads : counts) {
+            bool found = false;
+            times.push_back(best_of(cfg.repeat, [&] {
+                found = solve(threads);
+            }));
+            if (answer >= 0 && answer != static_cast<int>(found)) {
+                status = 1;
+            }
+            answer = found ? 1 : 0;
+        }
+        std::cout << std::right << std::setw(8) << answer;
+        for (double seconds : times) {
+            std::cout << std::setw(9) << std::fixed << std::setprecision(3) << seconds * 1000 << " ms";
+        }
+        std::cout << "  x" << std::setprecision(2) << times.front() / times.back() << std::endl;
+    };
+
+    for (std::uint32_t q : {61u, 127u, 211u}) {
+        std::vector<std::vector<std::uint32_t>> lines = projective_plane(q);
+        const std::size_t size = lines.size();
+        const Matrix matrix{size, size, std::move(lines)};
+        for (Engine engine : kParallelEngines) {
+            if (engine == Engine::Bitset && q > 61) {
+                continue;
+            }
+            run_case("plane q=" + std::to_string(q), engine, [&](std::size_t threads) {
+                return run_engine(matrix, engine, nullptr, threads);
+            });
+        }
+    }
+    if (!cfg.file.empty()) {
+        run_case(cfg.file.filename().string(), Engine::Auto, [&](std::size_t threads) {
+            FastRowReader reader(cfg.file.string());
+            return has_cycle_4(reader, Engine::Auto, nullptr, threads);
+        });
+    }
+
+    if (status != 0) {
+        std::cerr << "Error: thread counts disagree\n";
+    }
+    return status;
+}
+
+// Задержка add_row, пока матрица растёт до cfg.rows строк: M = rows,
+// в строке 2..16 случайных единиц. Сводка по десятичным отрезкам номеров
+// строк — задержка не должна расти вместе с матрицей, кроме редких
+// удвоений таблицы (они видны в max). Затем снимок: запись, загрузка и
+// продолжение с загруженного состояния — ответы обязаны совпасть.
+int bench_incremental(const BenchConfig& cfg) {
+    using Clock = std::chrono::steady_clock;
+    const std::size_t cols = cfg.rows;
+    std::mt19937 rng(cfg.seed);
+    std::uniform_int_distribution<std::size_t> ones_dist(2, 16);
+    std::uniform_int_distribution<std::uint32_t> col_dist(0, static_cast<std::uint32_t>(cols - 1));
+    auto random_row = [&] {
+        std::vector<std::uint32_t> row(ones_dist(rng));
+        for (auto& c : row) {
+            c = col_dist(rng);
+        }
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+        return row;
+    };
+
+    std::cout << std::right << std::setw(18) << "rows" << std::setw(12) << "mean" << std::setw(12) << "p50"
+              << std::setw(12) << "p99" << std::setw(12) << "max" << std::setw(10) << "closing" << std::setw(12)
+              << "state" << '\n';
+    IncrementalDetector detector(cols);
+    std::vector<double> latencies;
+    std::size_t closing = 0;
+    std::size_t bucket_start = 0;
+    for (std::size_t r = 0; r < cfg.rows; ++r) {
+        const std::vector<std::uint32_t> row = random_row();
+        const auto start = Clock::now();
+        closing += detector.add_row(row) ? 1 : 0;
+        latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+        if (r + 1 == cfg.rows || (r + 1) % (bucket_start == 0 ? 10 : bucket_start * 10) == 0) {
+            std::sort(latencies.begin(), latencies.end());
+            double sum = 0;
+            for (double us : latencies) {
+                sum += us;
+            }
+            const std::string range = std::to_string(bucket_start + 1) + ".." + std::to_string(r + 1);
+            std::cout << std::setw(18) << range << std::fixed << std::setprecision(3) << std::setw(9)
+                      << sum / latencies.size() << " us" << std::setw(9) << latencies[latencies.size() / 2] << " us"
+                      << std::setw(9) << latencies[latencies.size() * 99 / 100] << " us" << std::setw(9)
+                      << latencies.back() << " us" << std::setw(10) << closing << std::setw(8)
+                      << detector.memory_bytes() / 1024 << " KiB" << std::endl;
+            latencies.clear();
+            closing = 0;
+            bucket_start = r + 1;
+        }
+    }
+
+    const fs::path path = fs::temp_directory_path() / ("homework_6_bench_" + std::to_string(::getpid()) + ".state");
+    const double save_seconds = best_of(1, [&] {
+        detector.save(path.string());
+    });
+    IncrementalDetector restored(1);
+    const double load_seconds = best_of(1, [&] {
+        restored = IncrementalDetector::load(path.string());
+    });
+    std::cout << "snapshot: " << fs::file_size(path) / 1024 << " KiB, save " << std::setprecision(1)
+              << save_seconds * 1000 << " ms, load " << load_seconds * 1000 << " ms\n";
+    fs::remove(path);
+
+    // После загрузки — те же ответы, что у детектора, который не сохранялся.
+    int status = 0;
+    for (std::size_t r = 0; r < 1000; ++r) {
+        const std::vector<std::uint32_t> row = random_row();
+        const bool expected = detector.add_row(row);
+        if (restored.add_row(row) != expected ||
+            (expected && (restored.cycle().r1 != detector.cycle().r1 || restored.cycle().r2 != detector.cycle().r2))) {
+            status = 1;
+        }
+    }
+    if (status != 0) {
+        std::cerr << "Error: restored detector disagrees\n";
+    }
+    return status;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const BenchConfig cfg = parse_args(argc, argv);
+        if (cfg.suite == "check") {
+            return bench_check(cfg);
+        }
+        if (cfg.suite == "engines") {
+            return bench_engines(cfg);
+        }
+        if (cfg.suite == "count") {
+            return bench_count(cfg);
+        }
+        if (cfg.suite == "incremental") {
+            return bench_incremental(cfg);
+        }
+        if (cfg.suite == "parse") {
+            return bench_parse(cfg);
+        }
+        if (cfg.suite == "threads") {
+            return bench_threads(cfg);
+        }
+        print_usage(argv[0]);
+        return 1;
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bits.hpp"
+#include "fast_reader.hpp"
+
+// Двоичный формат матрицы. Заголовок — 24 байта, little-endian:
+//   "H6BM", uint32 layout, uint64 N, uint64 M,
+// дальше N строк в одной из раскладок:
+//   bits  — строка как (M + 63) / 64 слов uint64, столбец c — бит c % 64
+//           слова c / 64, хвост последнего слова нулевой;
+//   lists — uint32 k, затем k номеров столбцов uint32 по возрастанию.
+// bits занимает M / 8 байт на строку против M + 1 в тексте, lists —
+// 4 (k + 1) и выгоднее, пока в строке меньше M / 32 единиц. Обе раскладки
+// пишутся потоком, строка за строкой, а читаются прямо из mmap: номера
+// столбцов копируются или снимаются с битов, без разбора текста.
+enum class BinaryLayout : std::uint32_t {
+    Bits = 1,
+    Lists = 2,
+};
+
+struct BinaryHeader {
+    char magic[4];
+    std::uint32_t layout;
+    std::uint64_t rows;
+    std::uint64_t cols;
+};
+static_assert(sizeof(BinaryHeader) == 24, "binary header must be packed");
+
+constexpr char kBinaryMagic[4] = {'H', '6', 'B', 'M'};
+
+inline BinaryLayout parse_layout(const std::string& name) {
+    if (name == "bits") {
+        return BinaryLayout::Bits;
+    }
+    if (name == "lists") {
+        return BinaryLayout::Lists;
+    }
+    throw std::runtime_error("Unknown binary layout: " + name + " (expected bits|lists)");
+}
+
+inline const char* layout_name(BinaryLayout layout) {
+    return layout == BinaryLayout::Bits ? "bits" : "lists";
+}
+
+// Начинается ли файл с двоичного заголовка.
+inline bool is_binary_matrix(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kBinaryMagic)] = {};
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, kBinaryMagic, sizeof(magic)) == 0;
+}
+
+// Запись матрицы в двоичном формате по строкам, через крупный буфер.
+// finish() обязателен: он сбрасывает буфер и проверяет поток.
+class BinaryRowWriter {
+public:
+    BinaryRowWriter(std::ostream& out, BinaryLayout layout, std::uint64_t rows, std::uint64_t cols)
+        : out_(out), layout_(layout), words_((cols + 63) / 64) {
+        BinaryHeader header{};
+        std::memcpy(header.magic, kBinaryMagic, sizeof(kBinaryMagic));
+        header.layout = static_cast<std::uint32_t>(layout);
+        header.rows = rows;
+        header.cols = cols;
+        buffer_.reserve(kFlushBytes + sizeof(std::uint64_t) * words_ + sizeof(std::uint32_t));
+        put(&header, sizeof(header));
+    }
+
+    // columns — по возрастанию.
+    void add_row(const std::uint32_t* columns, std::size_t count) {
+        if (layout_ == BinaryLayout::Bits) {
+            row_bits_.assign(words_, 0);
+            for (std::size_t i = 0; i < count; ++i) {
+                row_bits_[columns[i] / 64] |= std::uint64_t{1} << (columns[i] % 64);
+            }
+            put(row_bits_.data(), row_bits_.size() * sizeof(std::uint64_t));
+        } else {
+            const auto k = static_cast<std::uint32_t>(count);
+            put(&k, sizeof(k));
+            put(columns, count * sizeof(std::uint32_t));
+        }
+        if (buffer_.size() >= kFlushBytes) {
+            flush();
+        }
+    }
+
+    void finish() {
+        flush();
+        out_.flush();
+        if (!out_) {
+            throw std::runtime_error("Failed to write output");
+        }
+    }
+
+private:
+    static constexpr std::size_t kFlushBytes = 4 * 1024 * 1024;
+
+    void put(const void* data, std::size_t bytes) {
+        const auto* begin = static_cast<const char*>(data);
+        buffer_.insert(buffer_.end(), begin, begin + bytes);
+    }
+
+    void flush() {
+        out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+
+    std::ostream& out_;
+    BinaryLayout layout_;
+    std::size_t words_;
+    std::vector<std::uint64_t> row_bits_;
+    std::vector<char> buffer_;
+};
+
+// Тот же интерфейс, что у TextRowReader. Обычный файл отображается
+// через mmap, stdin и каналы читаются блоками.
+class BinaryRowReader {
+public:
+    // path пустой — stdin.
+    explicit BinaryRowReader(const std::string& path, bool allow_mmap = true) : source_(path, allow_mmap) {
+        BinaryHeader header{};
+        source_.fill(sizeof(header));
+        if (source_.size() < sizeof(header)) {
+            throw std::runtime_error("Failed to read matrix header");
+        }
+        std::memcpy(&header, source_.data(), sizeof(header));
+        source_.consume(sizeof(header));
+        if (std::memcmp(header.magic, kBinaryMagic, sizeof(kBinaryMagic)) != 0 ||
+            (header.layout != static_cast<std::uint32_t>(BinaryLayout::Bits) &&
+             header.layout != static_cast<std::uint32_t>(BinaryLayout::Lists))) {
+            throw std::runtime_error("Invalid binary matrix header");
+        }
+        // Номера столбцов — uint32.
+        if (header.cols > (std::uint64_t{1} << 32)) {
+            throw std::runtime_error("Invalid matrix dimensions");
+        }
+        layout_ = static_cast<BinaryLayout>(header.layout);
+        rows_ = static_cast<std::size_t>(header.rows);
+        cols_ = static_cast<std::size_t>(header.cols);
+        words_ = (cols_ + 63) / 64;
+    }
+
+    std::size_t rows() const {
+        return rows_;
+    }
+
+    std::size_t cols() const {
+        return cols_;
+    }
+
+    BinaryLayout layout() const {
+        return layout_;
+    }
+
+    bool next(std::vector<std::uint32_t>& ones) {
+        if (row_ == rows_) {
+            return false;
+        }
+        ++row_;
+        ones.clear();
+        if (layout_ == BinaryLayout::Bits) {
+            read_bits(ones);
+        } else {
+            read_list(ones);
+        }
+        return true;
+    }
+
+private:
+    const char* take(std::size_t bytes) {
+        source_.fill(bytes);
+        if (source_.size() < bytes) {
+            throw std::runtime_error("Failed to read matrix row");
+        }
+        const char* data = source_.data();
+        source_.consume(bytes);
+        return data;
+    }
+
+    // Два прохода по строке (она в L1): popcount — под размер ответа,
+    // затем номера единиц без проверок ёмкости.
+    void read_bits(std::vector<std::uint32_t>& ones) {
+        const char* data = take(words_ * sizeof(std::uint64_t));
+        auto word_at = [data](std::size_t w) {
+            std::uint64_t word;
+            std::memcpy(&word, data + w * sizeof(word), sizeof(word));
+            return word;
+        };
+        if (words_ != 0 && cols_ % 64 != 0 && (word_at(words_ - 1) >> (cols_ % 64)) != 0) {
+            throw std::runtime_error("Invalid row length");
+        }
+        std::size_t count = 0;
+        for (std::size_t w = 0; w < words_; ++w) {
+            count += popcount64(word_at(w));
+        }
+        ones.resize(count);
+        std::uint32_t* out = ones.data();
+        for (std::size_t w = 0; w < words_; ++w) {
+            for (std::uint64_t word = word_at(w); word != 0; word &= word - 1) {
+                *out++ = static_cast<std::uint32_t>(w * 64 + lowest_bit64(word));
+            }
+        }
+    }
+
+    void read_list(std::vector<std::uint32_t>& ones) {
+        std::uint32_t count;
+        std::memcpy(&count, take(sizeof(count)), sizeof(count));
+        if (count > cols_) {
+            throw std::runtime_error("Invalid row length");
+        }
+        ones.resize(count);
+        std::memcpy(ones.data(), take(count * sizeof(std::uint32_t)), count * sizeof(std::uint32_t));
+        for (std::size_t i = 0; i < count; ++i) {
+            if (ones[i] >= cols_ || (i > 0 && ones[i] <= ones[i - 1])) {
+                throw std::runtime_error("Invalid matrix row");
+            }
+        }
+    }
+
+    detail::ByteSource source_;
+    BinaryLayout layout_ = BinaryLayout::Bits;
+    std::size_t rows_ = 0;
+    std::size_t cols_ = 0;
+    std::size_t words_ = 0;
+    std::size_t row_ = 0;
+};
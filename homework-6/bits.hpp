@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+inline unsigned popcount64(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_popcountll(x));
+#else
+    unsigned count = 0;
+    for (; x != 0; x &= x - 1) {
+        ++count;
+    }
+    return count;
+#endif
+}
+
+// Номер младшей единицы, x != 0.
+inline unsigned lowest_bit64(std::uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+    unsigned bit = 0;
+    for (; (x & 1) == 0; x >>= 1) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bits.hpp"
+#include "cycle.hpp"
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// Есть ли у двух битовых строк хотя бы два общих столбца: AND + popcount
+// с выходом на второй общей единице. Векторная ветка только отсеивает
+// нулевые блоки — у разреженных строк почти все пересечения пустые.
+inline bool share_two_columns(const std::uint64_t* a, const std::uint64_t* b, std::size_t words) {
+    unsigned common = 0;
+    std::size_t i = 0;
+#if defined(__AVX512F__)
+    for (; i + 8 <= words; i += 8) {
+        const __m512i va = _mm512_loadu_si512(a + i);
+        const __m512i vb = _mm512_loadu_si512(b + i);
+        for (unsigned mask = _mm512_test_epi64_mask(va, vb); mask != 0; mask &= mask - 1) {
+            const unsigned lane = static_cast<unsigned>(__builtin_ctz(mask));
+            common += popcount64(a[i + lane] & b[i + lane]);
+            if (common >= 2) {
+                return true;
+            }
+        }
+    }
+#endif
+#if defined(__AVX2__)
+    for (; i + 4 <= words; i += 4) {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        if (_mm256_testz_si256(va, vb)) {
+            continue;
+        }
+        for (std::size_t j = i; j < i + 4; ++j) {
+            common += popcount64(a[j] & b[j]);
+        }
+        if (common >= 2) {
+            return true;
+        }
+    }
+#endif
+    for (; i < words; ++i) {
+        common += popcount64(a[i] & b[i]);
+        if (common >= 2) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Число общих столбцов двух битовых строк — для подсчёта циклов, без
+// раннего выхода. Простой цикл: с -march=native компилятор сам
+// разворачивает его в векторный AND + popcount.
+inline std::uint64_t common_columns(const std::uint64_t* a, const std::uint64_t* b, std::size_t words) {
+    std::uint64_t common = 0;
+    for (std::size_t i = 0; i < words; ++i) {
+        common += popcount64(a[i] & b[i]);
+    }
+    return common;
+}
+
+// Движок для плотных матриц: строки хранятся битовыми масками, новая
+// строка сравнивается со всеми прежними. Стоимость строки — O(строк × M/64)
+// вместо O(k²) пар, а у плотной матрицы цикл находится в первых же строках.
+//
+// Хранится только отрезок слов от первой до последней единицы строки;
+// строки меньше чем с двумя единицами в цикл не входят и не хранятся.
+// Для параллельного поиска строки делятся между детекторами: каждый
+// сравнивает новую строку со своими прежними, а хранит её только один
+// (keep).
+//
+// count_row вместо раннего выхода считает общие столбцы со всеми
+// прежними строками: строка с k общими столбцами добавляет C(k, 2) циклов.
+class BitsetDetector {
+public:
+    BitsetDetector(std::size_t rows, std::size_t cols) {
+        // Резерв на всю матрицу — только если она невелика; иначе память
+        // растёт по мере чтения.
+        const std::size_t words = (cols + 63) / 64;
+        bits_.reserve(std::min<std::size_t>(rows * words, kReserveWords));
+    }
+
+    // columns — по возрастанию.
+    bool add_row(const std::uint32_t* columns, std::size_t count, bool keep = true) {
+        const std::uint64_t index = row_++;
+        if (count < 2 || (rows_.empty() && !keep)) {
+            return false;
+        }
+
+        const RowSpan row = push_bits(columns, count, index);
+        const std::uint64_t* own = bits_.data() + row.offset;
+        for (const RowSpan& other : rows_) {
+            const std::size_t first = std::max(row.first, other.first);
+            const std::size_t last = std::min(row.last, other.last);
+            if (first < last &&
+                share_two_columns(own + (first - row.first),
+                                  bits_.data() + other.offset + (first - other.first),
+                                  last - first)) {
+                record_cycle(other, row);
+                return true;
+            }
+        }
+        finish_row(row, keep);
+        return false;
+    }
+
+    // Сколько циклов строка замыкает с прежними.
+    std::uint64_t count_row(const std::uint32_t* columns, std::size_t count, bool keep = true) {
+        const std::uint64_t index = row_++;
+        if (count < 2 || (rows_.empty() && !keep)) {
+            return 0;
+        }
+
+        const RowSpan row = push_bits(columns, count, index);
+        const std::uint64_t* own = bits_.data() + row.offset;
+        std::uint64_t cycles = 0;
+        for (const RowSpan& other : rows_) {
+            const std::size_t first = std::max(row.first, other.first);
+            const std::size_t last = std::min(row.last, other.last);
+            if (first < last) {
+                cycles += choose_2(common_columns(own + (first - row.first),
+                                                  bits_.data() + other.offset + (first - other.first),
+                                                  last - first));
+            }
+        }
+        finish_row(row, keep);
+        return cycles;
+    }
+
+    // Цикл, после того как add_row вернул true.
+    const Cycle& cycle() const {
+        return cycle_;
+    }
+
+    std::size_t memory_bytes() const {
+        return bits_.capacity() * sizeof(std::uint64_t) + rows_.capacity() * sizeof(RowSpan);
+    }
+
+private:
+    static constexpr std::size_t kReserveWords = std::size_t{1} << 27;  // 1 GiB
+
+    struct RowSpan {
+        std::size_t offset;  // начало слов строки в bits_
+        std::size_t first;   // номер первого хранимого слова
+        std::size_t last;    // за последним
+        std::uint64_t index;  // номер строки в матрице
+    };
+
+    RowSpan push_bits(const std::uint32_t* columns, std::size_t count, std::uint64_t index) {
+        const RowSpan row{bits_.size(), columns[0] / 64, columns[count - 1] / 64 + 1, index};
+        bits_.resize(row.offset + (row.last - row.first), 0);
+        for (std::size_t i = 0; i < count; ++i) {
+            bits_[row.offset + columns[i] / 64 - row.first] |= std::uint64_t{1} << (columns[i] % 64);
+        }
+        return row;
+    }
+
+    void finish_row(const RowSpan& row, bool keep) {
+        if (keep) {
+            rows_.push_back(row);
+        } else {
+            bits_.resize(row.offset);
+        }
+    }
+
+    // Первые два общих столбца — повторным проходом по пересечению, он
+    // нужен один раз на всю матрицу.
+    void record_cycle(const RowSpan& first_row, const RowSpan& second_row) {
+        const std::size_t first = std::max(first_row.first, second_row.first);
+        const std::size_t last = std::min(first_row.last, second_row.last);
+        std::uint32_t found[2] = {0, 0};
+        unsigned count = 0;
+        for (std::size_t w = first; w < last && count < 2; ++w) {
+            std::uint64_t common = bits_[first_row.offset + (w - first_row.first)] &
+                                   bits_[second_row.offset + (w - second_row.first)];
+            for (; common != 0 && count < 2; common &= common - 1) {
+                found[count++] = static_cast<std::uint32_t>(w * 64 + lowest_bit64(common));
+            }
+        }
+        cycle_ = Cycle{first_row.index, second_row.index, found[0], found[1]};
+    }
+
+    std::vector<std::uint64_t> bits_;
+    std::vector<RowSpan> rows_;
+    std::uint64_t row_ = 0;
+    Cycle cycle_;
+};
@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "binary_format.hpp"
+#include "fast_reader.hpp"
+
+namespace {
+
+struct Config {
+    std::string to;  // text | bits | lists; пусто — text для двоичного входа, bits для текста
+    std::string input_file;
+    std::string output_file;
+};
+
+Config parse_args(int argc, char* argv[]) {
+    Config cfg;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--to") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --to");
+            }
+            cfg.to = argv[++i];
+            if (cfg.to != "text") {
+                parse_layout(cfg.to);
+            }
+            continue;
+        }
+        positional.push_back(arg);
+    }
+
+    if (positional.size() != 2) {
+        throw std::runtime_error(std::string("Usage: ") + argv[0] + " [--to text|bits|lists] input_file output_file");
+    }
+    cfg.input_file = positional[0];
+    cfg.output_file = positional[1];
+    return cfg;
+}
+
+template <typename Reader>
+void write_text(Reader& reader, std::ostream& out) {
+    out << reader.rows() << ' ' << reader.cols() << '\n';
+    constexpr std::size_t kFlushBytes = 4 * 1024 * 1024;
+    std::string buffer;
+    buffer.reserve(kFlushBytes + reader.cols() + 1);
+    std::vector<std::uint32_t> ones;
+    while (reader.next(ones)) {
+        const std::size_t start = buffer.size();
+        buffer.append(reader.cols(), '0');
+        for (std::uint32_t c : ones) {
+            buffer[start + c] = '1';
+        }
+        buffer.push_back('\n');
+        if (buffer.size() >= kFlushBytes) {
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+        }
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Failed to write output");
+    }
+}
+
+template <typename Reader>
+void write_binary(Reader& reader, BinaryLayout layout, std::ostream& out) {
+    BinaryRowWriter writer(out, layout, reader.rows(), reader.cols());
+    std::vector<std::uint32_t> ones;
+    while (reader.next(ones)) {
+        writer.add_row(ones.data(), ones.size());
+    }
+    writer.finish();
+}
+
+template <typename Reader>
+void convert(Reader& reader, const std::string& to, std::ostream& out) {
+    if (to == "text") {
+        write_text(reader, out);
+    } else {
+        write_binary(reader, parse_layout(to), out);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        Config cfg = parse_args(argc, argv);
+        const bool binary = is_binary_matrix(cfg.input_file);
+        if (cfg.to.empty()) {
+            cfg.to = binary ? "text" : "bits";
+        }
+
+        std::ofstream out(cfg.output_file, std::ios::binary);
+        if (!out) {
+            std::cerr << "Failed to open file: " << cfg.output_file << '\n';
+            return 1;
+        }
+        if (binary) {
+            BinaryRowReader reader(cfg.input_file);
+            convert(reader, cfg.to, out);
+        } else {
+            FastRowReader reader(cfg.input_file);
+            convert(reader, cfg.to, out);
+        }
+        return 0;
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Найденный цикл: строки r1 < r2 и столбцы c1 < c2, нумерация с нуля.
+// r1 — первая строка, в которой встретилась пара (c1, c2), r2 — строка,
+// которая её повторила.
+struct Cycle {
+    std::uint64_t r1 = 0;
+    std::uint64_t r2 = 0;
+    std::uint32_t c1 = 0;
+    std::uint32_t c2 = 0;
+};
+
+// Число циклов: у матрицы 2·10^5 × 2·10^5 из единиц их ~4·10^20, больше
+// чем влезает в 64 бита. __extension__ — __int128 не из ISO C++, без него
+// -Wpedantic предупреждает.
+__extension__ typedef unsigned __int128 CycleCount;
+
+inline std::string to_string(CycleCount count) {
+    if (count == 0) {
+        return "0";
+    }
+    std::string digits;
+    for (; count != 0; count /= 10) {
+        digits.insert(digits.begin(), static_cast<char>('0' + static_cast<int>(count % 10)));
+    }
+    return digits;
+}
+
+// C(k, 2): столько циклов дают две строки с k общими столбцами (и столько
+// же — пара столбцов, общая для k строк).
+inline std::uint64_t choose_2(std::uint64_t k) {
+    return k < 2 ? 0 : k * (k - 1) / 2;
+}
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bitset_detector.hpp"
+#include "cycle.hpp"
+#include "pair_hash.hpp"
+#include "pair_table.hpp"
+#include "parallel_detector.hpp"
+#include "sparse_detector.hpp"
+
+enum class Engine {
+    Auto,    // по плотности первых строк
+    Hash,    // пары столбцов в unordered_set (исходный вариант)
+    Table,   // пары в плоской таблице или битовой карте, с отсечением по Дирихле
+    Bitset,  // битовые строки, AND + popcount
+    Sparse,  // списки строк по столбцам, общие столбцы новой строки с прежними
+};
+
+inline Engine parse_engine(const std::string& name) {
+    if (name == "auto") {
+        return Engine::Auto;
+    }
+    if (name == "hash") {
+        return Engine::Hash;
+    }
+    if (name == "table") {
+        return Engine::Table;
+    }
+    if (name == "bitset") {
+        return Engine::Bitset;
+    }
+    if (name == "sparse") {
+        return Engine::Sparse;
+    }
+    throw std::runtime_error("Unknown --engine: " + name + " (expected auto|hash|table|bitset|sparse)");
+}
+
+inline const char* engine_name(Engine engine) {
+    switch (engine) {
+        case Engine::Hash:
+            return "hash";
+        case Engine::Table:
+            return "table";
+        case Engine::Bitset:
+            return "bitset";
+        case Engine::Sparse:
+            return "sparse";
+        default:
+            return "auto";
+    }
+}
+
+// Сколько первых строк читается до выбора движка.
+constexpr std::size_t kDensitySampleRows = 256;
+
+using RowSample = std::vector<std::vector<std::uint32_t>>;
+
+// Оценка по первым строкам матрицы.
+struct DensityEstimate {
+    double ones_per_row = 0.0;   // среднее k
+    double pairs_per_row = 0.0;  // среднее C(k, 2)
+    double words_per_row = 0.0;  // средняя длина отрезка битовой строки
+};
+
+inline DensityEstimate estimate_density(const RowSample& sample) {
+    DensityEstimate estimate;
+    if (sample.empty()) {
+        return estimate;
+    }
+    for (const auto& row : sample) {
+        const double k = static_cast<double>(row.size());
+        estimate.ones_per_row += k;
+        estimate.pairs_per_row += k * (k - 1) / 2;
+        if (row.size() >= 2) {
+            estimate.words_per_row += row.back() / 64 - row.front() / 64 + 1;
+        }
+    }
+    estimate.ones_per_row /= sample.size();
+    estimate.pairs_per_row /= sample.size();
+    estimate.words_per_row /= sample.size();
+    return estimate;
+}
+
+// Ожидаемое число пар во всей матрице; больше C(M, 2) + 1 не бывает —
+// дальше table отвечает без вставок.
+inline std::uint64_t expected_pairs(std::size_t rows, std::size_t cols, const DensityEstimate& estimate) {
+    const double limit = static_cast<double>(cols) * (static_cast<double>(cols) - 1) / 2 + 1;
+    return static_cast<std::uint64_t>(std::min(estimate.pairs_per_row * rows, limit));
+}
+
+// Худший случай (цикла нет): table тратит на пару вставку в таблицу,
+// bitset — по слову на каждую прежнюю строку, в среднем rows / 2 строк по
+// длине отрезка. Вставка считается в kTableCost раз дороже AND + popcount
+// слова.
+inline Engine choose_engine(std::size_t rows, std::size_t cols, const DensityEstimate& estimate) {
+    constexpr double kTableCost = 8.0;
+    const double table_cost = kTableCost * static_cast<double>(expected_pairs(rows, cols, estimate));
+    const double bitset_cost = static_cast<double>(rows) * rows / 2 * estimate.words_per_row;
+    return bitset_cost < table_cost ? Engine::Bitset : Engine::Table;
+}
+
+// Подсчёт проходит всю матрицу всегда. sparse тратит по инкременту на
+// каждую пару строк с общим столбцом — Σ C(k, 2) по столбцам, при
+// равномерной плотности M · C(N·k/M, 2); bitset — как при поиске. Случайный
+// инкремент считается в kSparseCost раз дороже слова.
+inline Engine choose_counter(std::size_t rows, std::size_t cols, const DensityEstimate& estimate) {
+    constexpr double kSparseCost = 4.0;
+    const double column_ones = cols == 0 ? 0.0 : static_cast<double>(rows) * estimate.ones_per_row / cols;
+    const double sparse_cost = kSparseCost * static_cast<double>(cols) * column_ones * column_ones / 2;
+    const double bitset_cost = static_cast<double>(rows) * rows / 2 * estimate.words_per_row;
+    return bitset_cost < sparse_cost ? Engine::Bitset : Engine::Sparse;
+}
+
+template <typename Reader>
+RowSample read_sample(Reader& reader) {
+    RowSample sample;
+    std::vector<std::uint32_t> ones;
+    while (sample.size() < kDensitySampleRows && reader.next(ones)) {
+        sample.push_back(ones);
+    }
+    return sample;
+}
+
+// Строки выборки, затем остальные; visit(columns, count) == true — стоп.
+template <typename Reader, typename Visit>
+bool for_each_row(Reader& reader, const RowSample& sample, Visit&& visit) {
+    for (const auto& row : sample) {
+        if (visit(row.data(), row.size())) {
+            return true;
+        }
+    }
+    std::vector<std::uint32_t> ones;
+    while (reader.next(ones)) {
+        if (visit(ones.data(), ones.size())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Есть ли в матрице 2 × 2 подматрица из единиц. Reader отдаёт строки
+// через next(ones); первые kDensitySampleRows строк сначала копятся для
+// оценки плотности (выбор движка и размер таблицы пар), потом идут в
+// движок как обычно.
+//
+// При threads > 1 работа делится между потоками: у table — пары по
+// меньшему столбцу, у bitset и sparse — хранимые строки. hash всегда
+// последовательный.
+//
+// С witness в него пишется найденный цикл. Движки помнят первую строку
+// каждой пары (или хранят сами строки), так что это почти бесплатно; только
+// table теряет битовую карту и досрочный ответ по Дирихле. При нескольких
+// потоках — цикл с наименьшей r2 из найденных, не обязательно тот же, что
+// при одном.
+template <typename Reader>
+bool has_cycle_4(Reader& reader,
+                 Engine engine = Engine::Auto,
+                 Engine* used = nullptr,
+                 std::size_t threads = 1,
+                 Cycle* witness = nullptr) {
+    const RowSample sample = read_sample(reader);
+    const DensityEstimate estimate = estimate_density(sample);
+    if (engine == Engine::Auto) {
+        engine = choose_engine(reader.rows(), reader.cols(), estimate);
+    }
+    if (used != nullptr) {
+        *used = engine;
+    }
+    const std::size_t rows = reader.rows();
+    const std::size_t cols = reader.cols();
+    const std::uint64_t pairs = expected_pairs(rows, cols, estimate);
+    const bool record = witness != nullptr;
+
+    if (threads > 1 && engine != Engine::Hash) {
+        std::vector<Cycle> cycles(threads);
+        std::vector<char> found(threads, 0);
+        auto report = [&](std::size_t part, const Cycle& cycle) {
+            cycles[part] = cycle;
+            found[part] = 1;
+            return true;
+        };
+        auto split_rows = [&](auto make_detector) {
+            return run_parallel(reader, sample, threads, [&](std::size_t part) {
+                return [&report, detector = make_detector(), part, threads](
+                           std::size_t row, const std::uint32_t* columns, std::size_t count) mutable {
+                    return detector.add_row(columns, count, row % threads == part) &&
+                           report(part, detector.cycle());
+                };
+            });
+        };
+        bool result = false;
+        if (engine == Engine::Table) {
+            result = run_parallel(reader, sample, threads, [&](std::size_t part) {
+                return [&report, detector = PairTableDetector(cols, pairs / threads, part, threads, record), part](
+                           std::size_t, const std::uint32_t* columns, std::size_t count) mutable {
+                    return detector.add_row(columns, count) && report(part, detector.cycle());
+                };
+            });
+        } else if (engine == Engine::Bitset) {
+            result = split_rows([&] { return BitsetDetector(rows / threads + 1, cols); });
+        } else {
+            result = split_rows([&] { return SparseDetector(cols); });
+        }
+        if (result && witness != nullptr) {
+            bool first = true;
+            for (std::size_t part = 0; part < threads; ++part) {
+                if (found[part] && (first || cycles[part].r2 < witness->r2)) {
+                    *witness = cycles[part];
+                    first = false;
+                }
+            }
+        }
+        return result;
+    }
+
+    auto run = [&](auto& detector) {
+        const bool found = for_each_row(reader, sample, [&](const std::uint32_t* columns, std::size_t count) {
+            return detector.add_row(columns, count);
+        });
+        if (found && witness != nullptr) {
+            *witness = detector.cycle();
+        }
+        return found;
+    };
+
+    switch (engine) {
+        case Engine::Hash: {
+            PairHashDetector detector(cols);
+            return run(detector);
+        }
+        case Engine::Bitset: {
+            BitsetDetector detector(rows, cols);
+            return run(detector);
+        }
+        case Engine::Sparse: {
+            SparseDetector detector(cols);
+            return run(detector);
+        }
+        default: {
+            PairTableDetector detector(cols, pairs, 0, 1, record);
+            return run(detector);
+        }
+    }
+}
+
+// Число циклов длины 4: сумма C(k, 2) по парам столбцов, где k — число
+// строк с обоими. Пары столбцов не перебираются: та же сумма получается по
+// парам строк, C(общих столбцов, 2), и её считают движки sparse и bitset.
+// Остальные движки считать не умеют.
+template <typename Reader>
+CycleCount count_cycles_4(Reader& reader, Engine engine = Engine::Auto, Engine* used = nullptr, std::size_t threads = 1) {
+    const RowSample sample = read_sample(reader);
+    const std::size_t rows = reader.rows();
+    const std::size_t cols = reader.cols();
+    if (engine == Engine::Auto) {
+        engine = choose_counter(rows, cols, estimate_density(sample));
+    }
+    if (engine != Engine::Sparse && engine != Engine::Bitset) {
+        throw std::runtime_error(std::string("Engine ") + engine_name(engine) +
+                                 " cannot count cycles (expected auto|sparse|bitset)");
+    }
+    if (used != nullptr) {
+        *used = engine;
+    }
+
+    if (threads > 1) {
+        // Своя сумма у каждого потока, в своей кеш-линии.
+        struct alignas(64) Total {
+            CycleCount value = 0;
+        };
+        std::vector<Total> totals(threads);
+        auto split_rows = [&](auto make_detector) {
+            run_parallel(reader, sample, threads, [&](std::size_t part) {
+                return [total = &totals[part].value, detector = make_detector(), part, threads](
+                           std::size_t row, const std::uint32_t* columns, std::size_t count) mutable {
+                    *total += detector.count_row(columns, count, row % threads == part);
+                    return false;
+                };
+            });
+        };
+        if (engine == Engine::Bitset) {
+            split_rows([&] { return BitsetDetector(rows / threads + 1, cols); });
+        } else {
+            split_rows([&] { return SparseDetector(cols); });
+        }
+        CycleCount total = 0;
+        for (const Total& part : totals) {
+            total += part.value;
+        }
+        return total;
+    }
+
+    CycleCount total = 0;
+    auto run = [&](auto& detector) {
+        for_each_row(reader, sample, [&](const std::uint32_t* columns, std::size_t count) {
+            total += detector.count_row(columns, count);
+            return false;
+        });
+    };
+    if (engine == Engine::Bitset) {
+        BitsetDetector detector(rows, cols);
+        run(detector);
+    } else {
+        SparseDetector detector(cols);
+        run(detector);
+    }
+    return total;
+}
@@ -0,0 +1,407 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define HOMEWORK6_HAVE_SIMD 1
+#endif
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "row_batch.hpp"
+
+namespace detail {
+
+// Байты входа: обычный файл целиком через mmap, канал или stdin — блоками
+// через read(). Окно [data(), data() + size()) — ещё не разобранные байты.
+class ByteSource {
+public:
+    ByteSource(const std::string& path, bool allow_mmap) {
+        if (path.empty()) {
+            fd_ = STDIN_FILENO;
+        } else {
+            fd_ = ::open(path.c_str(), O_RDONLY);
+            if (fd_ < 0) {
+                throw std::runtime_error("Failed to open file: " + path);
+            }
+            owns_fd_ = true;
+        }
+
+        struct stat st {};
+        if (allow_mmap && ::fstat(fd_, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* map = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (map != MAP_FAILED) {
+                ::madvise(map, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL);
+                map_ = static_cast<const char*>(map);
+                map_size_ = static_cast<std::size_t>(st.st_size);
+                begin_ = map_;
+                end_ = map_ + map_size_;
+                eof_ = true;
+            }
+        }
+    }
+
+    ByteSource(const ByteSource&) = delete;
+    ByteSource& operator=(const ByteSource&) = delete;
+
+    ~ByteSource() {
+        if (map_ != nullptr) {
+            ::munmap(const_cast<char*>(map_), map_size_);
+        }
+        if (owns_fd_) {
+            ::close(fd_);
+        }
+    }
+
+    const char* data() const {
+        return begin_;
+    }
+
+    std::size_t size() const {
+        return static_cast<std::size_t>(end_ - begin_);
+    }
+
+    void consume(std::size_t bytes) {
+        begin_ += bytes;
+    }
+
+    // Дочитывает, пока в окне меньше want байт и вход не кончился.
+    void fill(std::size_t want) {
+        if (size() >= want || eof_) {
+            return;
+        }
+        const std::size_t left = size();
+        if (buffer_.size() < std::max(want, kBlockBytes)) {
+            std::vector<char> bigger(std::max(want, kBlockBytes) * 2);
+            std::memcpy(bigger.data(), begin_, left);
+            buffer_.swap(bigger);
+        } else {
+            std::memmove(buffer_.data(), begin_, left);
+        }
+        begin_ = buffer_.data();
+        end_ = begin_ + left;
+
+        while (size() < want) {
+            const std::size_t space = buffer_.size() - size();
+            const ssize_t got = ::read(fd_, const_cast<char*>(end_), space);
+            if (got < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Failed to read input");
+            }
+            if (got == 0) {
+                eof_ = true;
+                return;
+            }
+            end_ += got;
+        }
+    }
+
+private:
+    static constexpr std::size_t kBlockBytes = 4 * 1024 * 1024;
+
+    int fd_ = -1;
+    bool owns_fd_ = false;
+    const char* map_ = nullptr;
+    std::size_t map_size_ = 0;
+    std::vector<char> buffer_;
+    const char* begin_ = nullptr;
+    const char* end_ = nullptr;
+    bool eof_ = false;
+};
+
+inline bool is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Дописывает в out номера столбцов с '1' среди n байт строки; false, если
+// внутри строки пробельный символ (строка короче M — как у operator>>).
+inline bool scan_row(const char* row, std::size_t n, std::vector<std::uint32_t>& out) {
+    std::size_t i = 0;
+#if defined(HOMEWORK6_HAVE_SIMD)
+    const __m128i one = _mm_set1_epi8('1');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i four = _mm_set1_epi8(4);
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        // '\t'..'\r' — это v - '\t' <= 4 без знака.
+        const __m128i shifted = _mm_sub_epi8(v, tab);
+        const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, four), shifted);
+        const __m128i blank = _mm_or_si128(control, _mm_cmpeq_epi8(v, space));
+        if (_mm_movemask_epi8(blank) != 0) {
+            return false;
+        }
+        for (unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, one))); mask != 0;
+             mask &= mask - 1) {
+            out.push_back(static_cast<std::uint32_t>(i + static_cast<std::size_t>(__builtin_ctz(mask))));
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        if (is_space(row[i])) {
+            return false;
+        }
+        if (row[i] == '1') {
+            out.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+    return true;
+}
+
+// Ограниченная очередь пачек от разборщика к решателю; пустые пачки
+// возвращаются разборщику, чтобы не выделять память заново.
+class BatchChannel {
+public:
+    explicit BatchChannel(std::size_t capacity) : capacity_(capacity) {}
+
+    std::unique_ptr<RowBatch> acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.empty()) {
+            return std::make_unique<RowBatch>();
+        }
+        std::unique_ptr<RowBatch> batch = std::move(free_.back());
+        free_.pop_back();
+        batch->clear();
+        return batch;
+    }
+
+    void release(std::unique_ptr<RowBatch> batch) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(std::move(batch));
+    }
+
+    // false — решатель закончил и пачки больше не нужны.
+    bool push(std::unique_ptr<RowBatch> batch) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return ready_.size() < capacity_ || cancelled_; });
+        if (cancelled_) {
+            return false;
+        }
+        ready_.push_back(std::move(batch));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // nullptr — пачек больше не будет.
+    std::unique_ptr<RowBatch> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return !ready_.empty() || closed_; });
+        if (ready_.empty()) {
+            return nullptr;
+        }
+        std::unique_ptr<RowBatch> batch = std::move(ready_.front());
+        ready_.pop_front();
+        not_full_.notify_one();
+        return batch;
+    }
+
+    // Разборщик: пачек больше не будет; error — почему.
+    void close(std::exception_ptr error = nullptr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        error_ = error;
+        not_empty_.notify_all();
+    }
+
+    // Решатель: дальше читать не нужно.
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        not_full_.notify_all();
+    }
+
+    std::exception_ptr error() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return error_;
+    }
+
+private:
+    std::size_t capacity_;
+    std::deque<std::unique_ptr<RowBatch>> ready_;
+    std::vector<std::unique_ptr<RowBatch>> free_;
+    bool closed_ = false;
+    bool cancelled_ = false;
+    std::exception_ptr error_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+}  // namespace detail
+
+// Быстрое чтение текстового формата: mmap или read() большими блоками,
+// поиск '1' SSE2-сравнением по 16 байт, без std::string на строку. Строки
+// разбираются отдельным потоком пачками и идут решателю через ограниченную
+// очередь, так что разбор идёт одновременно с поиском цикла. Интерфейс —
+// как у TextRowReader; ошибка формата всплывает в next() на той строке, где
+// её встретил бы построчный разбор.
+class FastRowReader {
+public:
+    // path пустой — stdin.
+    explicit FastRowReader(const std::string& path, bool allow_mmap = true)
+        : source_(path, allow_mmap), channel_(kQueueBatches) {
+        rows_ = read_dimension();
+        cols_ = read_dimension();
+        parser_ = std::thread([this] { parse(); });
+    }
+
+    FastRowReader(const FastRowReader&) = delete;
+    FastRowReader& operator=(const FastRowReader&) = delete;
+
+    ~FastRowReader() {
+        channel_.cancel();
+        parser_.join();
+    }
+
+    std::size_t rows() const {
+        return rows_;
+    }
+
+    std::size_t cols() const {
+        return cols_;
+    }
+
+    bool next(std::vector<std::uint32_t>& ones) {
+        while (batch_ == nullptr || row_ == batch_->ends.size()) {
+            if (batch_ != nullptr) {
+                channel_.release(std::move(batch_));
+            }
+            batch_ = channel_.pop();
+            row_ = 0;
+            if (batch_ == nullptr) {
+                if (std::exception_ptr error = channel_.error()) {
+                    std::rethrow_exception(error);
+                }
+                return false;
+            }
+        }
+        const std::uint32_t* row = batch_->row(row_);
+        ones.assign(row, row + batch_->row_size(row_));
+        ++row_;
+        return true;
+    }
+
+private:
+    // Пачка уходит решателю, когда набралось столько единиц, строк или байт.
+    static constexpr std::size_t kBatchOnes = 1 << 16;
+    static constexpr std::size_t kBatchRows = 1024;
+    static constexpr std::size_t kBatchBytes = 1 << 20;
+    static constexpr std::size_t kQueueBatches = 4;
+
+    // false — вход кончился.
+    bool skip_spaces() {
+        for (;;) {
+            source_.fill(1);
+            if (source_.size() == 0) {
+                return false;
+            }
+            const char* data = source_.data();
+            std::size_t i = 0;
+            while (i < source_.size() && detail::is_space(data[i])) {
+                ++i;
+            }
+            source_.consume(i);
+            if (source_.size() != 0) {
+                return true;
+            }
+        }
+    }
+
+    std::size_t read_dimension() {
+        if (!skip_spaces()) {
+            throw std::runtime_error("Failed to read matrix dimensions");
+        }
+        source_.fill(32);
+        const char* data = source_.data();
+        std::size_t i = 0;
+        bool negative = false;
+        if (i < source_.size() && (data[i] == '-' || data[i] == '+')) {
+            negative = data[i] == '-';
+            ++i;
+        }
+        std::size_t value = 0;
+        const std::size_t digits_from = i;
+        for (; i < source_.size() && data[i] >= '0' && data[i] <= '9' && i < 20; ++i) {
+            value = value * 10 + static_cast<std::size_t>(data[i] - '0');
+        }
+        if (i == digits_from) {
+            throw std::runtime_error("Failed to read matrix dimensions");
+        }
+        if (negative && value != 0) {
+            throw std::runtime_error("Invalid matrix dimensions");
+        }
+        source_.consume(i);
+        return value;
+    }
+
+    void parse() {
+        std::unique_ptr<RowBatch> batch = channel_.acquire();
+        try {
+            std::size_t batch_bytes = 0;
+            for (std::size_t r = 0; r < rows_; ++r) {
+                if (!skip_spaces()) {
+                    throw std::runtime_error("Failed to read matrix row");
+                }
+                // Строка и байт за ней: за строкой должен быть разделитель.
+                source_.fill(cols_ + 1);
+                const char* row = source_.data();
+                const bool complete = source_.size() >= cols_;
+                if (!complete || !detail::scan_row(row, cols_, batch->columns) ||
+                    (source_.size() > cols_ && !detail::is_space(row[cols_]))) {
+                    throw std::runtime_error("Invalid row length");
+                }
+                source_.consume(cols_);
+                batch->ends.push_back(batch->columns.size());
+                batch_bytes += cols_;
+
+                if (batch->columns.size() >= kBatchOnes || batch->ends.size() >= kBatchRows ||
+                    batch_bytes >= kBatchBytes) {
+                    if (!channel_.push(std::move(batch))) {
+                        return;
+                    }
+                    batch = channel_.acquire();
+                    batch_bytes = 0;
+                }
+            }
+            if (!batch->ends.empty() && !channel_.push(std::move(batch))) {
+                return;
+            }
+            channel_.close();
+        } catch (...) {
+            // Строки до ошибочной решатель должен получить.
+            if (batch != nullptr && !batch->ends.empty() && !channel_.push(std::move(batch))) {
+                return;
+            }
+            channel_.close(std::current_exception());
+        }
+    }
+
+    detail::ByteSource source_;
+    detail::BatchChannel channel_;
+    std::size_t rows_ = 0;
+    std::size_t cols_ = 0;
+    std::thread parser_;
+
+    std::unique_ptr<RowBatch> batch_;
+    std::size_t row_ = 0;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+// Плоская таблица пар столбцов с открытой адресацией (линейное
+// пробирование). Ключ (c1 << 32) | c2 при c1 < c2 никогда не равен нулю,
+// ноль — пустой слот. Хеш — умножение Фибоначчи, берутся старшие биты.
+// Ёмкость — степень двойки под ожидаемое число ключей; удвоение с
+// перехешированием, когда таблица заполнена наполовину.
+//
+// С with_rows рядом с ключом хранится номер строки, где он встретился
+// впервые.
+class FlatPairTable {
+public:
+    static constexpr std::size_t kInserted = ~std::size_t{0};
+
+    FlatPairTable() = default;
+
+    FlatPairTable(std::uint64_t expected, bool with_rows) : with_rows_(with_rows) {
+        std::size_t capacity = kMinCapacity;
+        while (capacity / 2 < expected) {
+            capacity *= 2;
+        }
+        resize(capacity);
+    }
+
+    static std::uint64_t key(std::uint32_t c1, std::uint32_t c2) {
+        return (static_cast<std::uint64_t>(c1) << 32) | c2;
+    }
+
+    // kInserted — ключ новый; иначе слот, где он уже был.
+    std::size_t insert(std::uint64_t key, std::uint32_t row) {
+        if (size_ >= slots_.size() / 2) {
+            resize(slots_.size() * 2);
+        }
+        return place(key, row);
+    }
+
+    // Строка первой встречи ключа из слота; только с with_rows.
+    std::uint32_t first_row(std::size_t slot) const {
+        return first_rows_[slot];
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    std::size_t memory_bytes() const {
+        return slots_.capacity() * sizeof(std::uint64_t) + first_rows_.capacity() * sizeof(std::uint32_t);
+    }
+
+    // Снимок — как есть, слоты подряд: восстановление без перехеширования.
+    void write(std::ostream& out) const {
+        const std::uint64_t header[3] = {slots_.size(), size_, with_rows_ ? 1u : 0u};
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(slots_.data()),
+                  static_cast<std::streamsize>(slots_.size() * sizeof(std::uint64_t)));
+        out.write(reinterpret_cast<const char*>(first_rows_.data()),
+                  static_cast<std::streamsize>(first_rows_.size() * sizeof(std::uint32_t)));
+    }
+
+    void read(std::istream& in) {
+        std::uint64_t header[3] = {};
+        if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] < kMinCapacity ||
+            (header[0] & (header[0] - 1)) != 0 || header[1] > header[0] / 2 || header[2] > 1) {
+            throw std::runtime_error("Invalid pair table snapshot");
+        }
+        with_rows_ = header[2] == 1;
+        set_capacity(static_cast<std::size_t>(header[0]));
+        size_ = static_cast<std::size_t>(header[1]);
+        in.read(reinterpret_cast<char*>(slots_.data()),
+                static_cast<std::streamsize>(slots_.size() * sizeof(std::uint64_t)));
+        in.read(reinterpret_cast<char*>(first_rows_.data()),
+                static_cast<std::streamsize>(first_rows_.size() * sizeof(std::uint32_t)));
+        if (!in) {
+            throw std::runtime_error("Invalid pair table snapshot");
+        }
+    }
+
+private:
+    static constexpr std::size_t kMinCapacity = 1024;
+    static constexpr std::uint64_t kMultiplier = 0x9E3779B97F4A7C15ull;
+
+    std::size_t place(std::uint64_t key, std::uint32_t row) {
+        std::size_t slot = static_cast<std::size_t>((key * kMultiplier) >> shift_);
+        while (slots_[slot] != 0) {
+            if (slots_[slot] == key) {
+                return slot;
+            }
+            slot = (slot + 1) & (slots_.size() - 1);
+        }
+        slots_[slot] = key;
+        if (with_rows_) {
+            first_rows_[slot] = row;
+        }
+        ++size_;
+        return kInserted;
+    }
+
+    void set_capacity(std::size_t capacity) {
+        slots_.assign(capacity, 0);
+        first_rows_.assign(with_rows_ ? capacity : 0, 0);
+        shift_ = 64;
+        for (std::size_t bits = capacity; bits > 1; bits /= 2) {
+            --shift_;
+        }
+        size_ = 0;
+    }
+
+    void resize(std::size_t capacity) {
+        std::vector<std::uint64_t> old;
+        std::vector<std::uint32_t> old_rows;
+        old.swap(slots_);
+        old_rows.swap(first_rows_);
+        set_capacity(capacity);
+        for (std::size_t slot = 0; slot < old.size(); ++slot) {
+            if (old[slot] != 0) {
+                place(old[slot], with_rows_ ? old_rows[slot] : 0);
+            }
+        }
+    }
+
+    bool with_rows_ = false;
+    std::vector<std::uint64_t> slots_;
+    std::vector<std::uint32_t> first_rows_;
+    std::size_t size_ = 0;
+    unsigned shift_ = 64;
+};
@@ -1,9 +1,12 @@
 #include <cstdint>
 #include <iostream>
 #include <random>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "binary_format.hpp"
+
 namespace {
 
 struct Config {
@@ -12,24 +15,40 @@ struct Config {
     int density_percent = 5;
     std::uint32_t seed = 42;
     bool inject_cycle = false;
+    std::string format = "text";  // text | bits | lists
 };
 
 Config parse_args(int argc, char* argv[]) {
     Config cfg;
-    if (argc >= 2) {
-        cfg.rows = std::stoi(argv[1]);
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--format") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --format");
+            }
+            cfg.format = argv[++i];
+            if (cfg.format != "text") {
+                parse_layout(cfg.format);
+            }
+            continue;
+        }
+        positional.push_back(arg);
+    }
+    if (positional.size() >= 1) {
+        cfg.rows = std::stoi(positional[0]);
     }
-    if (argc >= 3) {
-        cfg.cols = std::stoi(argv[2]);
+    if (positional.size() >= 2) {
+        cfg.cols = std::stoi(positional[1]);
     }
-    if (argc >= 4) {
-        cfg.density_percent = std::stoi(argv[3]);
+    if (positional.size() >= 3) {
+        cfg.density_percent = std::stoi(positional[2]);
     }
-    if (argc >= 5) {
-        cfg.seed = static_cast<std::uint32_t>(std::stoul(argv[4]));
+    if (positional.size() >= 4) {
+        cfg.seed = static_cast<std::uint32_t>(std::stoul(positional[3]));
     }
-    if (argc >= 6) {
-        cfg.inject_cycle = std::stoi(argv[5]) != 0;
+    if (positional.size() >= 5) {
+        cfg.inject_cycle = std::stoi(positional[4]) != 0;
     }
     return cfg;
 }
@@ -42,47 +61,87 @@ int main(int argc, char* argv[]) {
 
         if (cfg.rows <= 0 || cfg.cols <= 0 || cfg.density_percent < 0 || cfg.density_percent > 100) {
             std::cerr << "Usage: " << argv[0]
-                      << " [rows>0] [cols>0] [density:0..100] [seed] [inject_cycle:0|1]" << '\n';
+                      << " [--format text|bits|lists] [rows>0] [cols>0] [density:0..100] [seed] [inject_cycle:0|1]"
+                      << '\n';
             return 1;
         }
 
         std::mt19937 rng(cfg.seed);
         std::bernoulli_distribution bit(static_cast<double>(cfg.density_percent) / 100.0);
 
-        std::vector<std::string> matrix(static_cast<std::size_t>(cfg.rows),
-                                        std::string(static_cast<std::size_t>(cfg.cols), '0'));
-
-        for (int r = 0; r < cfg.rows; ++r) {
-            for (int c = 0; c < cfg.cols; ++c) {
-                matrix[static_cast<std::size_t>(r)][static_cast<std::size_t>(c)] = bit(rng) ? '1' : '0';
-            }
-        }
-
+        // Строки пишутся по мере генерации, без матрицы в памяти — так
+        // можно получить и 2·10^5 × 2·10^5. Углы внедряемого цикла берутся
+        // из отдельного генератора заранее; биты самой матрицы — те же, что
+        // и при генерации целиком.
+        int r1 = -1;
+        int r2 = -1;
+        int c1 = -1;
+        int c2 = -1;
         if (cfg.inject_cycle && cfg.rows >= 2 && cfg.cols >= 2) {
+            std::mt19937 inject_rng(cfg.seed ^ 0x9E3779B9u);
             std::uniform_int_distribution<int> row_dist(0, cfg.rows - 1);
             std::uniform_int_distribution<int> col_dist(0, cfg.cols - 1);
 
-            int r1 = row_dist(rng);
-            int r2 = row_dist(rng);
+            r1 = row_dist(inject_rng);
+            r2 = row_dist(inject_rng);
             while (r2 == r1) {
-                r2 = row_dist(rng);
+                r2 = row_dist(inject_rng);
             }
 
-            int c1 = col_dist(rng);
-            int c2 = col_dist(rng);
+            c1 = col_dist(inject_rng);
+            c2 = col_dist(inject_rng);
             while (c2 == c1) {
-                c2 = col_dist(rng);
+                c2 = col_dist(inject_rng);
             }
+        }
+
+        std::ios::sync_with_stdio(false);
 
-            matrix[static_cast<std::size_t>(r1)][static_cast<std::size_t>(c1)] = '1';
-            matrix[static_cast<std::size_t>(r1)][static_cast<std::size_t>(c2)] = '1';
-            matrix[static_cast<std::size_t>(r2)][static_cast<std::size_t>(c1)] = '1';
-            matrix[static_cast<std::size_t>(r2)][static_cast<std::size_t>(c2)] = '1';
+        // Двоичный вывод — та же матрица при том же seed: биты берутся из
+        // генератора в том же порядке.
+        if (cfg.format != "text") {
+            BinaryRowWriter writer(std::cout, parse_layout(cfg.format), static_cast<std::uint64_t>(cfg.rows),
+                                   static_cast<std::uint64_t>(cfg.cols));
+            std::vector<std::uint32_t> ones;
+            for (int r = 0; r < cfg.rows; ++r) {
+                ones.clear();
+                for (int c = 0; c < cfg.cols; ++c) {
+                    if (bit(rng) || ((r == r1 || r == r2) && (c == c1 || c == c2))) {
+                        ones.push_back(static_cast<std::uint32_t>(c));
+                    }
+                }
+                writer.add_row(ones.data(), ones.size());
+            }
+            writer.finish();
+            return 0;
         }
 
         std::cout << cfg.rows << ' ' << cfg.cols << '\n';
-        for (const auto& row : matrix) {
-            std::cout << row << '\n';
+
+        // Крупный буфер: запись блоками, а не по строке.
+        constexpr std::size_t kFlushBytes = 4 * 1024 * 1024;
+        std::string buffer;
+        buffer.reserve(kFlushBytes + static_cast<std::size_t>(cfg.cols) + 1);
+        for (int r = 0; r < cfg.rows; ++r) {
+            const std::size_t start = buffer.size();
+            for (int c = 0; c < cfg.cols; ++c) {
+                buffer.push_back(bit(rng) ? '1' : '0');
+            }
+            if (r == r1 || r == r2) {
+                buffer[start + static_cast<std::size_t>(c1)] = '1';
+                buffer[start + static_cast<std::size_t>(c2)] = '1';
+            }
+            buffer.push_back('\n');
+            if (buffer.size() >= kFlushBytes) {
+                std::cout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        }
+        std::cout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::cout.flush();
+        if (!std::cout) {
+            std::cerr << "Failed to write output" << '\n';
+            return 1;
         }
 
         return 0;
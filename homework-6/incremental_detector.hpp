@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cycle.hpp"
+#include "flat_pair_table.hpp"
+
+// Детектор для растущей матрицы: строки дописываются по одной, add_row
+// отвечает, замыкает ли новая строка цикл с какой-нибудь прежней. В
+// отличие от движков has_cycle_4, после первого цикла работа не
+// кончается: пары строки вставляются все, так что в таблице — все пары
+// всех строк, и ответ для каждой следующей строки честный. Строка стоит
+// O(k²) вставок (амортизированно — таблица изредка удваивается).
+//
+// Состояние пишется в файл (save) и поднимается из него (load) без
+// перехеширования: дописать строки к большой матрице — load, add_row
+// новых строк, save, без повторного прохода по старым.
+class IncrementalDetector {
+public:
+    explicit IncrementalDetector(std::size_t cols, std::uint64_t expected_pairs = 0)
+        : cols_(cols), table_(expected_pairs, true) {
+        if (cols > (std::uint64_t{1} << 32)) {
+            throw std::runtime_error("Invalid matrix dimensions");
+        }
+    }
+
+    // columns — по возрастанию.
+    bool add_row(const std::uint32_t* columns, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            if (columns[i] >= cols_ || (i > 0 && columns[i] <= columns[i - 1])) {
+                throw std::runtime_error("Invalid matrix row");
+            }
+        }
+        const auto row = static_cast<std::uint32_t>(rows_++);
+        bool closes = false;
+        for (std::size_t i = 0; i + 1 < count; ++i) {
+            for (std::size_t j = i + 1; j < count; ++j) {
+                const std::size_t slot = table_.insert(FlatPairTable::key(columns[i], columns[j]), row);
+                if (slot != FlatPairTable::kInserted && !closes) {
+                    closes = true;
+                    cycle_ = Cycle{table_.first_row(slot), row, columns[i], columns[j]};
+                }
+            }
+        }
+        if (closes && !has_cycle_) {
+            has_cycle_ = true;
+            first_cycle_ = cycle_;
+        }
+        return closes;
+    }
+
+    bool add_row(const std::vector<std::uint32_t>& columns) {
+        return add_row(columns.data(), columns.size());
+    }
+
+    // Цикл, который замкнула последняя строка, после того как add_row
+    // вернул true.
+    const Cycle& cycle() const {
+        return cycle_;
+    }
+
+    // Есть ли цикл во всей матрице и первый из найденных.
+    bool has_cycle() const {
+        return has_cycle_;
+    }
+
+    const Cycle& first_cycle() const {
+        return first_cycle_;
+    }
+
+    std::size_t rows() const {
+        return rows_;
+    }
+
+    std::size_t cols() const {
+        return cols_;
+    }
+
+    std::size_t memory_bytes() const {
+        return table_.memory_bytes();
+    }
+
+    // Снимок пишется во временный файл и переименовывается: прерванная
+    // запись не портит прежний снимок.
+    void save(const std::string& path) const {
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary);
+            const std::uint64_t header[] = {kVersion, cols_, rows_, has_cycle_ ? 1u : 0u,
+                                            first_cycle_.r1, first_cycle_.r2, first_cycle_.c1, first_cycle_.c2};
+            out.write(kMagic, sizeof(kMagic));
+            out.write(reinterpret_cast<const char*>(header), sizeof(header));
+            table_.write(out);
+            out.flush();
+            if (!out) {
+                throw std::runtime_error("Failed to write state: " + tmp);
+            }
+        }
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Failed to write state: " + path);
+        }
+    }
+
+    static IncrementalDetector load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+        char magic[sizeof(kMagic)] = {};
+        std::uint64_t header[8] = {};
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+            !in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != kVersion) {
+            throw std::runtime_error("Invalid state file: " + path);
+        }
+        IncrementalDetector detector(static_cast<std::size_t>(header[1]));
+        detector.rows_ = static_cast<std::size_t>(header[2]);
+        detector.has_cycle_ = header[3] != 0;
+        detector.first_cycle_ = Cycle{header[4], header[5], static_cast<std::uint32_t>(header[6]),
+                                      static_cast<std::uint32_t>(header[7])};
+        detector.cycle_ = detector.first_cycle_;
+        detector.table_.read(in);
+        return detector;
+    }
+
+private:
+    static constexpr char kMagic[4] = {'H', '6', 'P', 'S'};
+    static constexpr std::uint64_t kVersion = 1;
+
+    std::size_t cols_;
+    std::size_t rows_ = 0;
+    FlatPairTable table_;
+    bool has_cycle_ = false;
+    Cycle cycle_;
+    Cycle first_cycle_;
+};
@@ -1,76 +1,193 @@
-#include <cstdint>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
+#include "binary_format.hpp"
+#include "detector.hpp"
+#include "fast_reader.hpp"
+#include "incremental_detector.hpp"
+#include "row_reader.hpp"
+
 namespace {
 
-bool has_cycle_4(std::istream& input) {
-    int rows = 0;
-    int cols = 0;
-    if (!(input >> rows >> cols)) {
-        throw std::runtime_error("Failed to read matrix dimensions");
-    }
+struct Config {
+    Engine engine = Engine::Auto;
+    std::size_t threads = 1;
+    bool fast_parser = true;
+    std::string format = "auto";  // auto | text | binary
+    bool stats = false;
+    bool witness = false;
+    bool count = false;
+    std::string state_file;
+    std::string input_file;
+};
 
-    std::unordered_set<std::uint64_t> seen_pairs;
-    std::string row;
-    row.reserve(static_cast<std::size_t>(cols));
+Config parse_args(int argc, char* argv[]) {
+    Config cfg;
+    std::vector<std::string> positional;
 
-    for (int r = 0; r < rows; ++r) {
-        if (!(input >> row)) {
-            throw std::runtime_error("Failed to read matrix row");
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--engine") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --engine");
+            }
+            cfg.engine = parse_engine(argv[++i]);
+            continue;
         }
-        if (static_cast<int>(row.size()) != cols) {
-            throw std::runtime_error("Invalid row length");
+        if (arg == "--threads") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --threads");
+            }
+            cfg.threads = static_cast<std::size_t>(std::stoul(argv[++i]));
+            continue;
         }
-
-        std::vector<int> ones;
-        ones.reserve(static_cast<std::size_t>(cols / 4));
-        for (int c = 0; c < cols; ++c) {
-            if (row[static_cast<std::size_t>(c)] == '1') {
-                ones.push_back(c);
+        if (arg == "--parser") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --parser");
             }
+            const std::string parser = argv[++i];
+            if (parser != "fast" && parser != "stream") {
+                throw std::runtime_error("Unknown --parser: " + parser + " (expected fast|stream)");
+            }
+            cfg.fast_parser = parser == "fast";
+            continue;
         }
-
-        for (std::size_t i = 0; i < ones.size(); ++i) {
-            for (std::size_t j = i + 1; j < ones.size(); ++j) {
-                const std::uint64_t key =
-                    static_cast<std::uint64_t>(ones[i]) * static_cast<std::uint64_t>(cols) +
-                    static_cast<std::uint64_t>(ones[j]);
-                if (seen_pairs.find(key) != seen_pairs.end()) {
-                    return true;
-                }
-                seen_pairs.insert(key);
+        if (arg == "--state") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --state");
             }
+            cfg.state_file = argv[++i];
+            continue;
         }
+        if (arg == "--format") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --format");
+            }
+            cfg.format = argv[++i];
+            if (cfg.format != "auto" && cfg.format != "text" && cfg.format != "binary") {
+                throw std::runtime_error("Unknown --format: " + cfg.format + " (expected auto|text|binary)");
+            }
+            continue;
+        }
+        if (arg == "--stats") {
+            cfg.stats = true;
+            continue;
+        }
+        if (arg == "--witness") {
+            cfg.witness = true;
+            continue;
+        }
+        if (arg == "--count") {
+            cfg.count = true;
+            continue;
+        }
+        positional.push_back(arg);
     }
 
-    return false;
+    if (positional.size() > 1 || cfg.threads == 0 || (cfg.witness && cfg.count) ||
+        (cfg.count && !cfg.state_file.empty())) {
+        throw std::runtime_error(std::string("Usage: ") + argv[0] +
+                                 " [--engine auto|hash|table|bitset|sparse] [--threads K] [--parser fast|stream]"
+                                 " [--format auto|text|binary] [--witness | --count] [--state FILE] [--stats]"
+                                 " [input_file]");
+    }
+    if (!positional.empty()) {
+        cfg.input_file = positional.front();
+    }
+    return cfg;
+}
+
+void print_answer(bool found, const Cycle& cycle, const Config& cfg) {
+    std::cout << (found ? 1 : 0) << '\n';
+    if (found && cfg.witness) {
+        std::cout << cycle.r1 + 1 << ' ' << cycle.r2 + 1 << ' ' << cycle.c1 + 1 << ' ' << cycle.c2 + 1 << '\n';
+    }
+}
+
+// С --state вход — строки, дописанные к матрице из снимка (заголовок —
+// их число и M); снимка нет — матрица начинается с них. Ответ — про всю
+// матрицу, снимок перезаписывается.
+template <typename Reader>
+void solve_incremental(Reader& reader, const Config& cfg) {
+    IncrementalDetector detector = std::filesystem::exists(cfg.state_file)
+                                       ? IncrementalDetector::load(cfg.state_file)
+                                       : IncrementalDetector(reader.cols());
+    if (detector.cols() != reader.cols()) {
+        throw std::runtime_error("State has " + std::to_string(detector.cols()) + " columns, input has " +
+                                 std::to_string(reader.cols()));
+    }
+    std::vector<std::uint32_t> ones;
+    while (reader.next(ones)) {
+        detector.add_row(ones);
+    }
+    detector.save(cfg.state_file);
+    print_answer(detector.has_cycle(), detector.first_cycle(), cfg);
+    if (cfg.stats) {
+        std::cerr << "rows " << detector.rows() << ", state " << detector.memory_bytes() / 1024 << " KiB\n";
+    }
+}
+
+// Ответ 1/0; с --witness после 1 — строка "r1 r2 c1 c2" найденного цикла
+// (нумерация с единицы, как в условии); с --count — число циклов.
+template <typename Reader>
+void solve(Reader& reader, const Config& cfg) {
+    if (!cfg.state_file.empty()) {
+        solve_incremental(reader, cfg);
+        return;
+    }
+    Engine used = cfg.engine;
+    if (cfg.count) {
+        std::cout << to_string(count_cycles_4(reader, cfg.engine, &used, cfg.threads)) << '\n';
+    } else {
+        Cycle cycle;
+        const bool found = has_cycle_4(reader, cfg.engine, &used, cfg.threads, cfg.witness ? &cycle : nullptr);
+        print_answer(found, cycle, cfg);
+    }
+    if (cfg.stats) {
+        std::cerr << "engine " << engine_name(used) << '\n';
+    }
 }
 
 }  // namespace
 
 int main(int argc, char* argv[]) {
     try {
-        if (argc > 2) {
-            std::cerr << "Usage: " << argv[0] << " [input_file]" << '\n';
-            return 1;
+        const Config cfg = parse_args(argc, argv);
+
+        // Двоичный формат (binary_format.hpp) узнаётся по заголовку файла;
+        // со stdin — только явно, через --format binary.
+        const bool binary = cfg.format == "binary" ||
+                            (cfg.format == "auto" && !cfg.input_file.empty() && is_binary_matrix(cfg.input_file));
+        if (binary) {
+            BinaryRowReader reader(cfg.input_file);
+            solve(reader, cfg);
+            return 0;
+        }
+
+        // Быстрый разбор сам открывает файл (или читает stdin).
+        if (cfg.fast_parser) {
+            FastRowReader reader(cfg.input_file);
+            solve(reader, cfg);
+            return 0;
         }
 
-        if (argc == 2) {
-            std::ifstream file(argv[1]);
+        if (!cfg.input_file.empty()) {
+            std::ifstream file(cfg.input_file);
             if (!file) {
-                std::cerr << "Failed to open file: " << argv[1] << '\n';
+                std::cerr << "Failed to open file: " << cfg.input_file << '\n';
                 return 1;
             }
-            std::cout << (has_cycle_4(file) ? 1 : 0) << '\n';
+            TextRowReader reader(file);
+            solve(reader, cfg);
             return 0;
         }
 
-        std::cout << (has_cycle_4(std::cin) ? 1 : 0) << '\n';
+        TextRowReader reader(std::cin);
+        solve(reader, cfg);
         return 0;
     } catch (const std::exception& ex) {
         std::cerr << "Error: " << ex.what() << '\n';
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "cycle.hpp"
+
+// Исходный движок: все пары столбцов каждой строки в хеш-таблице.
+// Повтор пары — две строки с двумя общими столбцами, то есть цикл. Вместе
+// с парой хранится строка, где она встретилась впервые, — это r1 цикла.
+class PairHashDetector {
+public:
+    explicit PairHashDetector(std::size_t cols) : cols_(cols) {}
+
+    bool add_row(const std::uint32_t* columns, std::size_t count) {
+        const std::uint32_t row = row_++;
+        for (std::size_t i = 0; i < count; ++i) {
+            for (std::size_t j = i + 1; j < count; ++j) {
+                const std::uint64_t key =
+                    static_cast<std::uint64_t>(columns[i]) * cols_ + columns[j];
+                const auto [it, inserted] = seen_pairs_.try_emplace(key, row);
+                if (!inserted) {
+                    cycle_ = Cycle{it->second, row, columns[i], columns[j]};
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Цикл, после того как add_row вернул true.
+    const Cycle& cycle() const {
+        return cycle_;
+    }
+
+private:
+    std::uint64_t cols_;
+    std::uint32_t row_ = 0;
+    std::unordered_map<std::uint64_t, std::uint32_t> seen_pairs_;
+    Cycle cycle_;
+};
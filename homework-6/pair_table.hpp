@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cycle.hpp"
+#include "flat_pair_table.hpp"
+
+// Движок пар без аллокаций на вставку. Если цикла нет, все пары столбцов
+// всех строк различны, поэтому их не больше C(M, 2): как только сумма
+// C(k, 2) по строкам превышает эту границу, цикл есть без проверки
+// (принцип Дирихле). Отсюда и предсказуемая память — таблица никогда не
+// держит больше C(M, 2) пар.
+//
+// Пока битовая карта всех возможных пар не больше kBitmapBytes и не
+// больше таблицы под ожидаемое число пар, пары отмечаются в ней. Иначе —
+// плоская таблица (FlatPairTable) с ёмкостью по ожидаемому числу пар;
+// удвоение с перехешированием — только если оценка оказалась мала.
+//
+// Для параллельного поиска пары делятся между parts детекторами по
+// меньшему столбцу: детектор part видит только пары (a, b) с
+// a % parts == part, и граница Дирихле у него своя — число таких пар.
+//
+// С witness рядом с каждым ключом таблицы хранится строка, где пара
+// встретилась впервые, — это r1 цикла. Битовая карта строк не помнит, а
+// граница Дирихле отвечает без самого цикла, поэтому в этом режиме
+// всегда таблица и досрочного ответа нет; память всё равно ограничена
+// C(M, 2) пар — повтор найдётся раньше.
+class PairTableDetector {
+public:
+    PairTableDetector(std::size_t cols,
+                      std::uint64_t expected_pairs,
+                      std::size_t part = 0,
+                      std::size_t parts = 1,
+                      bool witness = false)
+        : part_(part), parts_(parts), witness_(witness) {
+        // Пары (a, b) своих a лежат в карте подряд: base_[a] + b.
+        std::uint64_t pairs = 0;
+        base_.assign(cols, 0);
+        for (std::size_t a = part; a < cols; a += parts) {
+            base_[a] = pairs - (a + 1);
+            pairs += cols - 1 - a;
+        }
+        max_pairs_ = pairs;
+
+        const std::uint64_t expected = std::min(expected_pairs, max_pairs_ + 1);
+        const std::uint64_t bitmap_bytes = max_pairs_ / 8 + 1;
+        if (!witness_ && bitmap_bytes <= kBitmapBytes && bitmap_bytes <= expected * 2 * sizeof(std::uint64_t)) {
+            bitmap_.assign(static_cast<std::size_t>(max_pairs_ / 64 + 1), 0);
+        } else {
+            table_ = FlatPairTable(expected, witness_);
+        }
+    }
+
+    // columns — по возрастанию.
+    bool add_row(const std::uint32_t* columns, std::size_t count) {
+        const std::uint32_t row = row_++;
+        std::uint64_t pairs = 0;
+        for (std::size_t i = 0; i + 1 < count; ++i) {
+            if (owns(columns[i])) {
+                pairs += count - 1 - i;
+            }
+        }
+        pairs_seen_ += pairs;
+        if (pairs_seen_ > max_pairs_ && !witness_) {
+            return true;
+        }
+        return bitmap_.empty() ? add_to_table(columns, count, row) : add_to_bitmap(columns, count);
+    }
+
+    // Цикл, после того как add_row вернул true; только с witness.
+    const Cycle& cycle() const {
+        return cycle_;
+    }
+
+    std::size_t memory_bytes() const {
+        return (base_.capacity() + bitmap_.capacity()) * sizeof(std::uint64_t) + table_.memory_bytes();
+    }
+
+private:
+    static constexpr std::uint64_t kBitmapBytes = 512ull * 1024 * 1024;
+
+    bool owns(std::uint32_t column) const {
+        return parts_ == 1 || column % parts_ == part_;
+    }
+
+    bool add_to_bitmap(const std::uint32_t* columns, std::size_t count) {
+        for (std::size_t i = 0; i + 1 < count; ++i) {
+            if (!owns(columns[i])) {
+                continue;
+            }
+            const std::uint64_t base = base_[columns[i]];
+            for (std::size_t j = i + 1; j < count; ++j) {
+                const std::uint64_t index = base + columns[j];
+                std::uint64_t& word = bitmap_[static_cast<std::size_t>(index / 64)];
+                const std::uint64_t bit = std::uint64_t{1} << (index % 64);
+                if ((word & bit) != 0) {
+                    return true;
+                }
+                word |= bit;
+            }
+        }
+        return false;
+    }
+
+    bool add_to_table(const std::uint32_t* columns, std::size_t count, std::uint32_t row) {
+        for (std::size_t i = 0; i + 1 < count; ++i) {
+            if (!owns(columns[i])) {
+                continue;
+            }
+            for (std::size_t j = i + 1; j < count; ++j) {
+                const std::size_t slot = table_.insert(FlatPairTable::key(columns[i], columns[j]), row);
+                if (slot != FlatPairTable::kInserted) {
+                    if (witness_) {
+                        cycle_ = Cycle{table_.first_row(slot), row, columns[i], columns[j]};
+                    }
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    std::size_t part_;
+    std::size_t parts_;
+    bool witness_;
+    std::uint32_t row_ = 0;
+    std::uint64_t max_pairs_ = 0;
+    std::uint64_t pairs_seen_ = 0;
+    std::vector<std::uint64_t> base_;
+    std::vector<std::uint64_t> bitmap_;
+    FlatPairTable table_;
+    Cycle cycle_;
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "row_batch.hpp"
+
+// Журнал пачек строк для нескольких читателей: каждый worker проходит все
+// пачки по порядку, пачка освобождается, когда её прочли все. Запись ждёт,
+// пока впереди больше capacity пачек, которые кто-то ещё не прочёл.
+class RowLog {
+public:
+    RowLog(std::size_t readers, std::size_t capacity) : readers_(readers), capacity_(capacity) {}
+
+    // false — поиск уже закончен.
+    bool append(std::shared_ptr<const RowBatch> batch) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return entries_.size() < capacity_ || cancelled_; });
+        if (cancelled_) {
+            return false;
+        }
+        entries_.push_back(Entry{std::move(batch), readers_});
+        not_empty_.notify_all();
+        return true;
+    }
+
+    // Пачка номер index; nullptr — пачек больше не будет.
+    std::shared_ptr<const RowBatch> get(std::size_t index) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this, index] {
+            return index < first_index_ + entries_.size() || closed_ || cancelled_;
+        });
+        if (cancelled_ || index >= first_index_ + entries_.size()) {
+            return nullptr;
+        }
+        Entry& entry = entries_[index - first_index_];
+        std::shared_ptr<const RowBatch> batch = entry.batch;
+        --entry.unread;
+        while (!entries_.empty() && entries_.front().unread == 0) {
+            entries_.pop_front();
+            ++first_index_;
+            not_full_.notify_one();
+        }
+        return batch;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<const RowBatch> batch;
+        std::size_t unread;
+    };
+
+    std::size_t readers_;
+    std::size_t capacity_;
+    std::deque<Entry> entries_;
+    std::size_t first_index_ = 0;
+    bool closed_ = false;
+    bool cancelled_ = false;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+// Параллельный поиск: вызывающий поток читает строки и раздаёт их пачками
+// всем threads worker'ам, каждый проверяет свою часть работы —
+// make_check(part) возвращает check(row, columns, count). Первый нашедший
+// цикл поднимает общий флаг: остальные бросают работу на следующей
+// строке, а чтение входа останавливается на следующей пачке.
+template <typename Reader, typename MakeCheck>
+bool run_parallel(Reader& reader,
+                  const std::vector<std::vector<std::uint32_t>>& sample,
+                  std::size_t threads,
+                  MakeCheck&& make_check) {
+    constexpr std::size_t kBatchOnes = 1 << 16;
+    constexpr std::size_t kBatchRows = 1024;
+    constexpr std::size_t kLogBatches = 8;
+
+    RowLog log(threads, kLogBatches);
+    std::atomic<bool> found{false};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto stop = [&] {
+        found.store(true);
+        log.cancel();
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (std::size_t part = 0; part < threads; ++part) {
+        workers.emplace_back([&, part] {
+            try {
+                auto check = make_check(part);
+                for (std::size_t index = 0;; ++index) {
+                    const std::shared_ptr<const RowBatch> batch = log.get(index);
+                    if (batch == nullptr) {
+                        return;
+                    }
+                    for (std::size_t r = 0; r < batch->rows(); ++r) {
+                        if (found.load(std::memory_order_relaxed)) {
+                            return;
+                        }
+                        if (check(batch->first_row + r, batch->row(r), batch->row_size(r))) {
+                            stop();
+                            return;
+                        }
+                    }
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                error = std::current_exception();
+                stop();
+            }
+        });
+    }
+
+    // Ошибка чтения всплывает, только если в уже прочитанных строках цикла
+    // нет — как при последовательном поиске.
+    std::exception_ptr read_error;
+    auto batch = std::make_shared<RowBatch>();
+    std::size_t next_row = 0;
+    auto publish = [&] {
+        const bool accepted = log.append(std::move(batch));
+        batch = std::make_shared<RowBatch>();
+        batch->first_row = next_row;
+        return accepted;
+    };
+    auto add = [&](const std::vector<std::uint32_t>& row) {
+        batch->add_row(row.data(), row.size());
+        ++next_row;
+        if (batch->columns.size() >= kBatchOnes || batch->rows() >= kBatchRows) {
+            return publish();
+        }
+        return true;
+    };
+
+    bool running = true;
+    try {
+        for (const auto& row : sample) {
+            running = running && add(row);
+        }
+        std::vector<std::uint32_t> ones;
+        while (running && reader.next(ones)) {
+            running = add(ones);
+        }
+    } catch (...) {
+        read_error = std::current_exception();
+    }
+    if (running && batch->rows() != 0) {
+        publish();
+    }
+    log.close();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (found.load()) {
+        return true;
+    }
+    if (read_error) {
+        std::rethrow_exception(read_error);
+    }
+    return false;
+}
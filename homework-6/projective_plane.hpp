@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// Матрица инцидентности проективной плоскости PG(2, q), q простое: строки —
+// прямые, столбцы — точки, N = M = q² + q + 1, в каждой строке q + 1
+// единиц. Две прямые пересекаются ровно в одной точке, поэтому циклов
+// длины 4 нет, а пар столбцов ровно C(M, 2) — худший случай для движков
+// пар (граница Дирихле достигается точно).
+//
+// Точки и прямые нормированы: (1, y, z), (0, 1, z), (0, 0, 1). Точки
+// прямой (a, b, c) находятся решением a·x + b·y + c·z = 0 за O(q).
+inline std::vector<std::vector<std::uint32_t>> projective_plane(std::uint32_t q) {
+    for (std::uint32_t d = 2; d * d <= q; ++d) {
+        if (q % d == 0) {
+            throw std::runtime_error("projective_plane: q must be prime");
+        }
+    }
+    if (q < 2) {
+        throw std::runtime_error("projective_plane: q must be prime");
+    }
+
+    const std::uint64_t p = q;
+    auto inverse = [p](std::uint64_t x) {
+        std::uint64_t result = 1;
+        for (std::uint64_t e = p - 2; e != 0; e /= 2, x = x * x % p) {
+            if (e % 2 != 0) {
+                result = result * x % p;
+            }
+        }
+        return result;
+    };
+    auto neg = [p](std::uint64_t x) { return (p - x % p) % p; };
+    auto point = [p](std::uint64_t x, std::uint64_t y, std::uint64_t z) -> std::uint32_t {
+        if (x != 0) {
+            return static_cast<std::uint32_t>(y * p + z);                  // (1, y, z)
+        }
+        if (y != 0) {
+            return static_cast<std::uint32_t>(p * p + z);                  // (0, 1, z)
+        }
+        return static_cast<std::uint32_t>(p * p + p);                      // (0, 0, 1)
+    };
+
+    std::vector<std::vector<std::uint32_t>> lines;
+    lines.reserve(static_cast<std::size_t>(p * p + p + 1));
+    auto add_line = [&](std::uint64_t a, std::uint64_t b, std::uint64_t c) {
+        std::vector<std::uint32_t> row;
+        row.reserve(q + 1);
+        const std::uint64_t c_inv = c != 0 ? inverse(c) : 0;
+        // (1, y, z): a + b·y + c·z = 0
+        for (std::uint64_t y = 0; y < p; ++y) {
+            if (c != 0) {
+                row.push_back(point(1, y, neg(a + b * y) * c_inv % p));
+            } else if ((a + b * y) % p == 0) {
+                for (std::uint64_t z = 0; z < p; ++z) {
+                    row.push_back(point(1, y, z));
+                }
+            }
+        }
+        // (0, 1, z): b + c·z = 0
+        if (c != 0) {
+            row.push_back(point(0, 1, neg(b) * c_inv % p));
+        } else if (b == 0) {
+            for (std::uint64_t z = 0; z < p; ++z) {
+                row.push_back(point(0, 1, z));
+            }
+        }
+        // (0, 0, 1): c = 0
+        if (c == 0) {
+            row.push_back(point(0, 0, 1));
+        }
+        std::sort(row.begin(), row.end());
+        lines.push_back(std::move(row));
+    };
+
+    for (std::uint64_t b = 0; b < p; ++b) {
+        for (std::uint64_t c = 0; c < p; ++c) {
+            add_line(1, b, c);
+        }
+    }
+    for (std::uint64_t c = 0; c < p; ++c) {
+        add_line(0, 1, c);
+    }
+    add_line(0, 0, 1);
+    return lines;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Пачка строк матрицы в CSR: столбцы всех строк подряд, ends[r] — конец
+// строки r в columns. first_row — номер первой строки пачки в матрице.
+struct RowBatch {
+    std::vector<std::uint32_t> columns;
+    std::vector<std::size_t> ends;
+    std::size_t first_row = 0;
+
+    std::size_t rows() const {
+        return ends.size();
+    }
+
+    const std::uint32_t* row(std::size_t r) const {
+        return columns.data() + (r == 0 ? 0 : ends[r - 1]);
+    }
+
+    std::size_t row_size(std::size_t r) const {
+        return ends[r] - (r == 0 ? 0 : ends[r - 1]);
+    }
+
+    void add_row(const std::uint32_t* row, std::size_t count) {
+        columns.insert(columns.end(), row, row + count);
+        ends.push_back(columns.size());
+    }
+
+    void clear() {
+        columns.clear();
+        ends.clear();
+        first_row = 0;
+    }
+};
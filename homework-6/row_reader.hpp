@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Построчное чтение матрицы в текстовом формате задачи. Строка отдаётся
+// списком номеров столбцов с единицами, по возрастанию.
+class TextRowReader {
+public:
+    explicit TextRowReader(std::istream& input) : input_(input) {
+        long long rows = 0;
+        long long cols = 0;
+        if (!(input_ >> rows >> cols)) {
+            throw std::runtime_error("Failed to read matrix dimensions");
+        }
+        if (rows < 0 || cols < 0) {
+            throw std::runtime_error("Invalid matrix dimensions");
+        }
+        rows_ = static_cast<std::size_t>(rows);
+        cols_ = static_cast<std::size_t>(cols);
+        row_.reserve(cols_);
+    }
+
+    std::size_t rows() const {
+        return rows_;
+    }
+
+    std::size_t cols() const {
+        return cols_;
+    }
+
+    // false — строки кончились.
+    bool next(std::vector<std::uint32_t>& ones) {
+        if (read_ == rows_) {
+            return false;
+        }
+        if (!(input_ >> row_)) {
+            throw std::runtime_error("Failed to read matrix row");
+        }
+        if (row_.size() != cols_) {
+            throw std::runtime_error("Invalid row length");
+        }
+
+        ones.clear();
+        for (std::size_t c = 0; c < cols_; ++c) {
+            if (row_[c] == '1') {
+                ones.push_back(static_cast<std::uint32_t>(c));
+            }
+        }
+        ++read_;
+        return true;
+    }
+
+private:
+    std::istream& input_;
+    std::size_t rows_ = 0;
+    std::size_t cols_ = 0;
+    std::size_t read_ = 0;
+    std::string row_;
+};
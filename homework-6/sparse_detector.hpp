@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cycle.hpp"
+
+// Движок по столбцам: для каждого столбца — список прежних строк с
+// единицей в нём. Новая строка проходит списки своих столбцов и считает
+// общие столбцы с каждой встреченной строкой. Строка стоит сумму высот
+// своих столбцов, вся матрица — Σ C(k, 2) по столбцам вместо Σ C(k, 2)
+// по строкам у table; памяти — по 4 байта на единицу. Главное применение —
+// подсчёт циклов на разреженных матрицах (count_row).
+//
+// Как и у bitset, для параллельной работы строки делятся между
+// детекторами: каждый сравнивает новую строку со своими, хранит её один
+// (keep).
+class SparseDetector {
+public:
+    explicit SparseDetector(std::size_t cols) : column_rows_(cols) {}
+
+    // columns — по возрастанию.
+    bool add_row(const std::uint32_t* columns, std::size_t count, bool keep = true) {
+        const std::uint64_t index = row_++;
+        bool found = false;
+        for (std::size_t i = 0; i < count && !found; ++i) {
+            for (std::uint32_t other : column_rows_[columns[i]]) {
+                std::uint32_t& common = common_[other];
+                if (common == 0) {
+                    touched_.push_back(other);
+                    first_common_[other] = columns[i];
+                }
+                if (++common == 2) {
+                    cycle_ = Cycle{rows_[other], index, first_common_[other], columns[i]};
+                    found = true;
+                    break;
+                }
+            }
+        }
+        clear_touched();
+        if (!found) {
+            store(columns, count, index, keep);
+        }
+        return found;
+    }
+
+    // Сколько циклов строка замыкает с прежними.
+    std::uint64_t count_row(const std::uint32_t* columns, std::size_t count, bool keep = true) {
+        const std::uint64_t index = row_++;
+        for (std::size_t i = 0; i < count; ++i) {
+            for (std::uint32_t other : column_rows_[columns[i]]) {
+                if (common_[other]++ == 0) {
+                    touched_.push_back(other);
+                }
+            }
+        }
+        std::uint64_t cycles = 0;
+        for (std::uint32_t other : touched_) {
+            cycles += choose_2(common_[other]);
+        }
+        clear_touched();
+        store(columns, count, index, keep);
+        return cycles;
+    }
+
+    // Цикл, после того как add_row вернул true.
+    const Cycle& cycle() const {
+        return cycle_;
+    }
+
+private:
+    // Строки меньше чем с двумя единицами в цикл не входят.
+    void store(const std::uint32_t* columns, std::size_t count, std::uint64_t index, bool keep) {
+        if (!keep || count < 2) {
+            return;
+        }
+        const auto slot = static_cast<std::uint32_t>(rows_.size());
+        rows_.push_back(index);
+        common_.push_back(0);
+        first_common_.push_back(0);
+        for (std::size_t i = 0; i < count; ++i) {
+            column_rows_[columns[i]].push_back(slot);
+        }
+    }
+
+    void clear_touched() {
+        for (std::uint32_t other : touched_) {
+            common_[other] = 0;
+        }
+        touched_.clear();
+    }
+
+    std::vector<std::vector<std::uint32_t>> column_rows_;  // хранимые строки по столбцам
+    std::vector<std::uint64_t> rows_;                      // номер хранимой строки в матрице
+    std::vector<std::uint32_t> common_;                    // общие столбцы с новой строкой
+    std::vector<std::uint32_t> first_common_;              // первый из них
+    std::vector<std::uint32_t> touched_;
+    std::uint64_t row_ = 0;
+    Cycle cycle_;
+};
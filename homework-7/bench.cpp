@@ -0,0 +1,974 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "compressed_input.hpp"
+#include "directory_walker.hpp"
+#include "file_processor.hpp"
+#include "global_counts.hpp"
+#include "indexer.hpp"
+#include "tokenizer.hpp"
+#include "top_words.hpp"
+#include "word_table.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct BenchConfig {
+    std::string suite;
+    fs::path input_dir;
+    std::size_t minlen = 3;
+    std::size_t repeat = 3;
+    std::size_t threads = 8;
+    std::size_t shards = 16;
+    fs::path csv_path;
+    fs::path json_path;
+};
+
+void print_usage(const char* prog) {
+    std::cout <<
+        "Usage: " << prog << " <suite> [options] <dir>\n"
+        "Suites:\n"
+        "  io                compare ifstream and mmap readers, MB/s (single thread)\n"
+        "  compressed        plain vs gzip/zstd copies of the corpus, serial vs pipelined decompression\n"
+        "  merge             single-mutex merge vs sharded table with flush policies\n"
+        "  scheduler         TaskQueue vs work stealing, discovery vs largest-first order\n"
+        "  topm              full sort vs bounded-heap top-M selection\n"
+        "  tokenizer         scalar vs SIMD vs --utf8 tokenizer, GB/s, plus differential checks\n"
+        "  table             std::unordered_map vs flat table with arena: time and peak RSS\n"
+        "  sweep             merge strategies x thread counts: time, MB/s, speedup, peak RSS\n"
+        "Options:\n"
+        "  --minlen L        minimal word length (default: 3)\n"
+        "  --repeat R        runs per variant, the best one is reported (default: 3)\n"
+        "  --threads K       max worker threads, swept as 1, 2, 4, ..., K (default: 8)\n"
+        "  --shards N        shard count for the sharded table (default: 16)\n"
+        "  --csv FILE        sweep: also write the results as CSV\n"
+        "  --json FILE       sweep: also write the results as JSON\n"
+        "\nExample:\n"
+        "  homework_7_generator --out data --files 10 --mib 50 --seed 42\n"
+        "  " << prog << " io data\n";
+}
+
+BenchConfig parse_args(int argc, char* argv[]) {
+    BenchConfig cfg;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto need = [&](const char* name) -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error(std::string("Missing value for ") + name);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--minlen") {
+            cfg.minlen = static_cast<std::size_t>(std::stoul(need("--minlen")));
+        } else if (arg == "--repeat") {
+            cfg.repeat = static_cast<std::size_t>(std::stoul(need("--repeat")));
+        } else if (arg == "--threads") {
+            cfg.threads = static_cast<std::size_t>(std::stoul(need("--threads")));
+        } else if (arg == "--shards") {
+            cfg.shards = static_cast<std::size_t>(std::stoul(need("--shards")));
+        } else if (arg == "--csv") {
+            cfg.csv_path = need("--csv");
+        } else if (arg == "--json") {
+            cfg.json_path = need("--json");
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() != 2 || cfg.minlen == 0 || cfg.repeat == 0 ||
+        cfg.threads == 0 || cfg.shards == 0) {
+        print_usage(argv[0]);
+        throw std::runtime_error("Invalid arguments");
+    }
+    cfg.suite = positional[0];
+    cfg.input_dir = positional[1];
+    return cfg;
+}
+
+std::vector<fs::path> list_files(const fs::path& dir, std::uint64_t& total_bytes) {
+    std::vector<fs::path> files;
+    total_bytes = 0;
+    walk_directory(dir, WalkOptions{true, 1}, [&](const fs::path& path, std::uint64_t size) {
+        files.push_back(path);
+        total_bytes += size;
+    });
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// Лучшее время из repeat прогонов, в секундах.
+double best_of(std::size_t repeat, const std::function<void()>& run) {
+    double best = 0.0;
+    for (std::size_t i = 0; i < repeat; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+void print_row(const std::string& name, double seconds, std::uint64_t bytes, const std::string& note) {
+    const double mb = static_cast<double>(bytes) / 1e6;
+    std::cout << std::left << std::setw(16) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(3) << seconds << " s"
+              << std::setw(12) << std::setprecision(1) << mb / seconds << " MB/s"
+              << "  " << note << '\n';
+}
+
+bool same_counts(const WordTable& lhs, const WordTable& rhs) {
+    bool same = lhs.size() == rhs.size();
+    lhs.for_each([&same, &rhs](std::string_view word, std::uint64_t count) {
+        same = same && rhs.count(word) == count;
+    });
+    return same;
+}
+
+int bench_io(const BenchConfig& cfg) {
+    std::uint64_t total_bytes = 0;
+    const std::vector<fs::path> files = list_files(cfg.input_dir, total_bytes);
+    std::cout << "Files: " << files.size() << ", " << total_bytes / (1024 * 1024) << " MiB\n";
+
+    WordTable reference;
+    bool mismatch = false;
+    for (IoMode mode : {IoMode::Stream, IoMode::Mmap}) {
+        WordTable counts;
+        const double seconds = best_of(cfg.repeat, [&] {
+            counts = WordTable();
+            for (const auto& path : files) {
+                process_file(path, mode, cfg.minlen, Encoding::Ascii, counts);
+            }
+        });
+        print_row(io_mode_name(mode), seconds, total_bytes, std::to_string(counts.size()) + " words");
+
+        if (mode == IoMode::Stream) {
+            reference = std::move(counts);
+        } else if (!same_counts(counts, reference)) {
+            mismatch = true;
+        }
+    }
+
+    if (mismatch) {
+        std::cerr << "Error: readers produced different counts\n";
+        return 1;
+    }
+    return 0;
+}
+
+std::vector<std::size_t> thread_sweep(std::size_t max_threads) {
+    std::vector<std::size_t> result;
+    for (std::size_t threads = 1; threads < max_threads; threads *= 2) {
+        result.push_back(threads);
+    }
+    result.push_back(max_threads);
+    return result;
+}
+
+int bench_merge(const BenchConfig& cfg) {
+    struct Variant {
+        std::string name;
+        MergeStrategy strategy;
+        FlushPolicy flush;
+    };
+    const std::vector<Variant> variants = {
+        {"single", MergeStrategy::Single, {}},
+        {"sharded", MergeStrategy::Sharded, {}},
+        {"sharded/file", MergeStrategy::Sharded, {1, 0}},
+        {"sharded/16MiB", MergeStrategy::Sharded, {0, 16ull * 1024 * 1024}},
+    };
+
+    std::uint64_t total_bytes = 0;
+    const std::vector<fs::path> files = list_files(cfg.input_dir, total_bytes);
+    std::cout << "Files: " << files.size() << ", " << total_bytes / (1024 * 1024) << " MiB\n";
+
+    for (std::size_t threads : thread_sweep(cfg.threads)) {
+        std::cout << "threads=" << threads << '\n';
+        for (const auto& variant : variants) {
+            IndexerOptions options;
+            options.threads = threads;
+            options.minlen = cfg.minlen;
+            options.io = IoMode::Mmap;
+            options.flush = variant.flush;
+
+            std::uint64_t contended = 0;
+            std::size_t words = 0;
+            const double seconds = best_of(cfg.repeat, [&] {
+                GlobalCounts global(variant.strategy, cfg.shards);
+                run_indexer(options, cfg.input_dir, global);
+                contended = 0;
+                for (const auto& shard : global.stats()) {
+                    contended += shard.contended;
+                }
+                words = global.size();
+            });
+            print_row("  " + variant.name, seconds, total_bytes,
+                      std::to_string(words) + " words, " + std::to_string(contended) + " contended locks");
+        }
+    }
+    return 0;
+}
+
+int bench_scheduler(const BenchConfig& cfg) {
+    using Ms = std::chrono::duration<double, std::milli>;
+    struct Variant {
+        Scheduler scheduler;
+        TaskOrder order;
+    };
+    const std::vector<Variant> variants = {
+        {Scheduler::Queue, TaskOrder::Discovery},
+        {Scheduler::Steal, TaskOrder::Discovery},
+        {Scheduler::Queue, TaskOrder::LargestFirst},
+        {Scheduler::Steal, TaskOrder::LargestFirst},
+    };
+
+    std::uint64_t total_bytes = 0;
+    const std::vector<fs::path> files = list_files(cfg.input_dir, total_bytes);
+    std::cout << "Files: " << files.size() << ", " << total_bytes / (1024 * 1024) << " MiB\n";
+
+    for (std::size_t threads : thread_sweep(cfg.threads)) {
+        std::cout << "threads=" << threads << '\n';
+        for (const auto& variant : variants) {
+            IndexerOptions options;
+            options.threads = threads;
+            options.minlen = cfg.minlen;
+            options.io = IoMode::Mmap;
+            options.scheduler = variant.scheduler;
+            options.order = variant.order;
+            options.recursive = true;
+            options.walkers = threads;
+
+            IndexerStats stats;
+            const double seconds = best_of(cfg.repeat, [&] {
+                GlobalCounts global(MergeStrategy::Sharded, cfg.shards);
+                stats = run_indexer(options, cfg.input_dir, global);
+            });
+
+            // Дисбаланс: самый загруженный worker относительно среднего.
+            double busy_max = 0;
+            double busy_sum = 0;
+            double idle_sum = 0;
+            for (const auto& worker : stats.workers) {
+                busy_max = std::max(busy_max, Ms(worker.busy).count());
+                busy_sum += Ms(worker.busy).count();
+                idle_sum += Ms(worker.idle).count();
+            }
+            std::ostringstream note;
+            note << std::fixed << std::setprecision(2) << "busy max/mean "
+                 << (busy_sum > 0 ? busy_max * threads / busy_sum : 0.0)
+                 << ", idle " << std::setprecision(1) << idle_sum << " ms total, "
+                 << stats.steals << " steals";
+            print_row(std::string("  ") + scheduler_name(variant.scheduler) + '/' + task_order_name(variant.order),
+                      seconds, total_bytes, note.str());
+        }
+    }
+    return 0;
+}
+
+int bench_topm(const BenchConfig& cfg) {
+    IndexerOptions options;
+    options.threads = cfg.threads;
+    options.minlen = cfg.minlen;
+    options.io = IoMode::Mmap;
+
+    GlobalCounts global(MergeStrategy::Sharded, cfg.shards);
+    run_indexer(options, cfg.input_dir, global);
+    std::cout << "Vocabulary: " << global.size() << " words\n";
+
+    bool mismatch = false;
+    for (std::size_t limit : {10, 1000, 100000}) {
+        std::vector<WordEntry> sorted;
+        const double sort_seconds = best_of(cfg.repeat, [&] {
+            sorted.clear();
+            sorted.reserve(global.size());
+            for (std::size_t shard = 0; shard < global.shard_count(); ++shard) {
+                global.shard(shard).for_each([&sorted](std::string_view word, std::uint64_t count) {
+                    sorted.push_back(WordEntry{word, count});
+                });
+            }
+            std::sort(sorted.begin(), sorted.end(), ranks_before);
+            sorted.resize(std::min(limit, sorted.size()));
+        });
+
+        std::vector<WordEntry> selected;
+        const double heap_seconds = best_of(cfg.repeat, [&] {
+            selected = select_top(global, limit, 1);
+        });
+        std::vector<WordEntry> parallel;
+        const double parallel_seconds = best_of(cfg.repeat, [&] {
+            parallel = select_top(global, limit, cfg.threads);
+        });
+
+        auto same = [&sorted](const std::vector<WordEntry>& other) {
+            return std::equal(sorted.begin(), sorted.end(), other.begin(), other.end(),
+                              [](const WordEntry& lhs, const WordEntry& rhs) {
+                                  return lhs.word == rhs.word && lhs.count == rhs.count;
+                              });
+        };
+        mismatch = mismatch || !same(selected) || !same(parallel);
+
+        std::cout << "M=" << limit << std::fixed << std::setprecision(4)
+                  << "  sort " << sort_seconds << " s"
+                  << "  heap " << heap_seconds << " s"
+                  << "  heap x" << cfg.threads << ' ' << parallel_seconds << " s\n";
+    }
+
+    if (mismatch) {
+        std::cerr << "Error: top-M selection differs from full sort\n";
+        return 1;
+    }
+    return 0;
+}
+
+std::string read_all(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Сжимает path в out (gzip или zstd) для бенчмарка распаковки.
+bool compress_file(const fs::path& path, const fs::path& out, Compression compression) {
+    const std::string data = read_all(path);
+    switch (compression) {
+#if defined(HOMEWORK7_HAVE_ZLIB)
+        case Compression::Gzip: {
+            gzFile gz = gzopen(out.string().c_str(), "wb6");
+            if (gz == nullptr) {
+                return false;
+            }
+            const bool ok = data.empty() ||
+                gzwrite(gz, data.data(), static_cast<unsigned>(data.size())) == static_cast<int>(data.size());
+            return gzclose(gz) == Z_OK && ok;
+        }
+#endif
+#if defined(HOMEWORK7_HAVE_ZSTD)
+        case Compression::Zstd: {
+            std::string packed(ZSTD_compressBound(data.size()), '\0');
+            const std::size_t size = ZSTD_compress(packed.data(), packed.size(), data.data(), data.size(), 3);
+            if (ZSTD_isError(size) != 0) {
+                return false;
+            }
+            std::ofstream file(out, std::ios::binary);
+            file.write(packed.data(), static_cast<std::streamsize>(size));
+            return static_cast<bool>(file);
+        }
+#endif
+        default:
+            return false;
+    }
+}
+
+// Всё, что библиотека может распаковать из (возможно обрезанного) файла,
+// когда вход целиком в памяти, — эталон для process_compressed.
+std::string decode_prefix(const fs::path& path, Compression compression) {
+    std::string packed = read_all(path);
+    std::string out;
+    switch (compression) {
+#if defined(HOMEWORK7_HAVE_ZLIB)
+        case Compression::Gzip: {
+            z_stream stream{};
+            if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+                throw std::runtime_error("inflateInit2 failed");
+            }
+            stream.next_in = reinterpret_cast<Bytef*>(packed.data());
+            stream.avail_in = static_cast<uInt>(packed.size());
+            int rc = Z_OK;
+            while (rc == Z_OK) {
+                const std::size_t filled = out.size();
+                out.resize(filled + 64 * 1024);
+                stream.next_out = reinterpret_cast<Bytef*>(out.data() + filled);
+                stream.avail_out = 64 * 1024;
+                rc = inflate(&stream, Z_NO_FLUSH);
+                out.resize(out.size() - stream.avail_out);
+            }
+            inflateEnd(&stream);
+            return out;
+        }
+#endif
+#if defined(HOMEWORK7_HAVE_ZSTD)
+        case Compression::Zstd: {
+            ZSTD_DCtx* context = ZSTD_createDCtx();
+            ZSTD_inBuffer in{packed.data(), packed.size(), 0};
+            std::size_t rc = 1;
+            while (rc != 0 && ZSTD_isError(rc) == 0) {
+                const std::size_t filled = out.size();
+                out.resize(filled + 64 * 1024);
+                ZSTD_outBuffer chunk{out.data() + filled, 64 * 1024, 0};
+                rc = ZSTD_decompressStream(context, &chunk, &in);
+                out.resize(filled + chunk.pos);
+                if (chunk.pos == 0 && in.pos == in.size) {
+                    break;
+                }
+            }
+            ZSTD_freeDCtx(context);
+            return out;
+        }
+#endif
+        default:
+            throw std::runtime_error(std::string("built without ") + compression_name(compression) + " support");
+    }
+}
+
+int bench_compressed(const BenchConfig& cfg) {
+    std::uint64_t total_bytes = 0;
+    const std::vector<fs::path> files = list_files(cfg.input_dir, total_bytes);
+    std::cout << "Files: " << files.size() << ", " << total_bytes / (1024 * 1024) << " MiB\n";
+
+    WordTable reference;
+    const double plain_seconds = best_of(cfg.repeat, [&] {
+        reference = WordTable();
+        for (const auto& path : files) {
+            process_file(path, IoMode::Mmap, cfg.minlen, Encoding::Ascii, reference);
+        }
+    });
+    print_row("plain mmap", plain_seconds, total_bytes, std::to_string(reference.size()) + " words");
+
+    const fs::path work_dir = fs::temp_directory_path() / "homework_7_bench_compressed";
+    bool mismatch = false;
+    for (Compression compression : {Compression::Gzip, Compression::Zstd}) {
+        if (!compression_supported(compression)) {
+            std::cout << compression_name(compression) << ": not built in, skipped\n";
+            continue;
+        }
+
+        fs::remove_all(work_dir);
+        fs::create_directories(work_dir);
+        std::vector<fs::path> packed;
+        std::uint64_t packed_bytes = 0;
+        for (const auto& path : files) {
+            packed.push_back(work_dir / path.filename());
+            if (!compress_file(path, packed.back(), compression)) {
+                fs::remove_all(work_dir);
+                throw std::runtime_error("Failed to compress " + path.string());
+            }
+            packed_bytes += fs::file_size(packed.back());
+        }
+
+        std::ostringstream ratio;
+        ratio << std::fixed << std::setprecision(2) << "ratio "
+              << static_cast<double>(total_bytes) / static_cast<double>(std::max<std::uint64_t>(1, packed_bytes));
+        // MB/s считаются по распакованному объёму.
+        for (bool pipelined : {false, true}) {
+            WordTable counts;
+            const double seconds = best_of(cfg.repeat, [&] {
+                counts = WordTable();
+                WordCounter<WordTable> counter(counts);
+                for (const auto& path : packed) {
+                    process_compressed(path, compression, cfg.minlen, Encoding::Ascii, counter, pipelined);
+                }
+            });
+            print_row(std::string(compression_name(compression)) + (pipelined ? " pipelined" : " serial"),
+                      seconds, total_bytes, ratio.str());
+            mismatch = mismatch || !same_counts(counts, reference);
+        }
+
+        // Обрезанный посередине поток: учитывается всё, что распаковалось,
+        // включая хвост последнего блока. Предупреждение в stderr ожидаемо.
+        const auto largest = std::max_element(packed.begin(), packed.end(), [](const fs::path& a, const fs::path& b) {
+            return fs::file_size(a) < fs::file_size(b);
+        });
+        if (largest != packed.end()) {
+            const fs::path truncated = work_dir / "truncated";
+            fs::copy_file(*largest, truncated);
+            fs::resize_file(truncated, fs::file_size(truncated) / 2);
+            const std::string prefix = decode_prefix(truncated, compression);
+            WordTable expected;
+            WordCounter<WordTable> expected_counter(expected);
+            std::string scratch;
+            tokenize(prefix, cfg.minlen, Encoding::Ascii, scratch, expected_counter);
+            for (bool pipelined : {false, true}) {
+                WordTable counts;
+                const std::uint64_t decoded = process_compressed(truncated, compression, cfg.minlen, Encoding::Ascii,
+                                                                 WordCounter<WordTable>(counts), pipelined);
+                std::cout << compression_name(compression) << (pipelined ? " pipelined" : " serial")
+                          << " truncated: " << decoded << " of " << prefix.size() << " prefix bytes, "
+                          << counts.size() << " words\n";
+                mismatch = mismatch || decoded != prefix.size() || !same_counts(counts, expected);
+            }
+        }
+
+        // Слово длиннее блока распаковки в середине блока: сжатая копия должна
+        // дать те же счётчики, что и исходный файл.
+        const fs::path long_plain = work_dir / "long_token.txt";
+        {
+            std::ofstream file(long_plain, std::ios::binary);
+            file << "first words before the token ";
+            for (std::size_t i = 0; i < 3 * detail::kDecodedBlockSize / 10 + 1234; ++i) {
+                file << "abcdefghij";
+            }
+            file << " and words after it\n";
+        }
+        const fs::path long_packed = work_dir / "long_token.packed";
+        if (!compress_file(long_plain, long_packed, compression)) {
+            fs::remove_all(work_dir);
+            throw std::runtime_error("Failed to compress " + long_plain.string());
+        }
+        WordTable long_expected;
+        process_file(long_plain, IoMode::Mmap, cfg.minlen, Encoding::Ascii, long_expected);
+        for (bool pipelined : {false, true}) {
+            WordTable counts;
+            process_compressed(long_packed, compression, cfg.minlen, Encoding::Ascii, WordCounter<WordTable>(counts),
+                               pipelined);
+            std::cout << compression_name(compression) << (pipelined ? " pipelined" : " serial") << " long token: "
+                      << counts.size() << " words, plain " << long_expected.size() << '\n';
+            mismatch = mismatch || !same_counts(counts, long_expected);
+        }
+    }
+    fs::remove_all(work_dir);
+
+    if (mismatch) {
+        std::cerr << "Error: compressed input produced different counts\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Все слова, которые выдал токенизатор, через '\n'.
+template <typename Tokenize>
+std::string collect_tokens(Tokenize&& tokenize_fn, std::string_view text, std::size_t minlen) {
+    std::string out;
+    std::string scratch;
+    tokenize_fn(text, minlen, scratch, [&out](std::string_view word) {
+        out.append(word.data(), word.size());
+        out.push_back('\n');
+    });
+    return out;
+}
+
+// Сравнивает SIMD- и скалярный токенизаторы на случайных буферах со всеми
+// граничными классами байтов: регистры, '_', цифры, разделители, UTF-8.
+bool differential_check(std::size_t rounds) {
+    static const std::string_view alphabet =
+        "abcxyzABCXYZ019_ \t\n.,:;=/[]@`{\x7f\x80\xd0\xb0\xff";
+    std::mt19937_64 rng(12345);
+    std::uniform_int_distribution<std::size_t> length_dist(0, 300);
+    std::uniform_int_distribution<std::size_t> char_dist(0, alphabet.size() - 1);
+    std::uniform_int_distribution<std::size_t> minlen_dist(1, 4);
+
+    auto scalar = [](auto&&... args) { tokenize_scalar(std::forward<decltype(args)>(args)...); };
+    auto simd = [](auto&&... args) { tokenize_simd(std::forward<decltype(args)>(args)...); };
+
+    std::string text;
+    for (std::size_t round = 0; round < rounds; ++round) {
+        text.resize(length_dist(rng));
+        for (char& c : text) {
+            c = alphabet[char_dist(rng)];
+        }
+        const std::size_t minlen = minlen_dist(rng);
+        // Смещение начала проверяет невыровненные загрузки.
+        for (std::size_t shift = 0; shift < 3 && shift <= text.size(); ++shift) {
+            const std::string_view view = std::string_view(text).substr(shift);
+            if (collect_tokens(scalar, view, minlen) != collect_tokens(simd, view, minlen)) {
+                std::cerr << "Mismatch on input: \"" << view << "\" (minlen " << minlen << ")\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// То же для режима UTF-8: блочная версия против посимвольной на буферах
+// из корректных символов (кириллица, ß, греческий, CJK, эмодзи, знаки) и
+// битых последовательностей: обрезанных, overlong, суррогатов.
+bool utf8_differential_check(std::size_t rounds) {
+    static const std::vector<std::string> pieces = {
+        "a", "Z", "_", "7", " ", ".", "\n",
+        "\xd0\xb0", "\xd0\x90", "\xd0\x81", "\xd1\x91", "\xc3\x9f", "\xc3\x89", "\xc3\x97",
+        "\xce\xa3", "\xcf\x82", "\xc2\xa0", "\xc2\xab", "\xc5\xbf", "\xe2\x80\x94", "\xe4\xb8\xad",
+        "\xe1\xba\xa0", "\xef\xbc\xa1", "\xf0\x9f\x98\x80", "\xf0\x90\x90\x80",
+        "\x80", "\xbf", "\xd0", "\xe2\x80", "\xf0\x9f\x98", "\xc0\xaf", "\xe0\x80\xaf",
+        "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xff"};
+    std::mt19937_64 rng(54321);
+    std::uniform_int_distribution<std::size_t> length_dist(0, 150);
+    std::uniform_int_distribution<std::size_t> piece_dist(0, pieces.size() - 1);
+    std::uniform_int_distribution<std::size_t> minlen_dist(1, 4);
+
+    auto scalar = [](auto&&... args) { tokenize_utf8_scalar(std::forward<decltype(args)>(args)...); };
+    auto blocks = [](auto&&... args) { tokenize_utf8(std::forward<decltype(args)>(args)...); };
+
+    std::string text;
+    for (std::size_t round = 0; round < rounds; ++round) {
+        text.clear();
+        for (std::size_t n = length_dist(rng); n > 0; --n) {
+            text += pieces[piece_dist(rng)];
+        }
+        const std::size_t minlen = minlen_dist(rng);
+        // Смещение режет и первую последовательность.
+        for (std::size_t shift = 0; shift < 3 && shift <= text.size(); ++shift) {
+            const std::string_view view = std::string_view(text).substr(shift);
+            if (collect_tokens(scalar, view, minlen) != collect_tokens(blocks, view, minlen)) {
+                std::cerr << "UTF-8 mismatch on input: \"" << view << "\" (minlen " << minlen << ")\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Синтетический лог с русскими сообщениями: кириллица в разных регистрах
+// вперемешку с ASCII-полями, примерно bytes байт.
+std::string make_cyrillic_log(std::size_t bytes) {
+    static const std::vector<std::string> words = {
+        "\xd0\x9e\xd1\x88\xd0\xb8\xd0\xb1\xd0\xba\xd0\xb0",                          // Ошибка
+        "\xd0\xbf\xd0\xbe\xd0\xb4\xd0\xba\xd0\xbb\xd1\x8e\xd1\x87\xd0\xb5\xd0\xbd\xd0\xb8\xd1\x8f",  // подключения
+        "\xd0\xba", "\xd0\xb1\xd0\xb0\xd0\xb7\xd0\xb5",                                  // к базе
+        "\xd0\x9f\xd0\x9e\xd0\x9b\xd0\xac\xd0\x97\xd0\x9e\xd0\x92\xd0\x90\xd0\xa2\xd0\x95\xd0\x9b\xd0\xac",  // ПОЛЬЗОВАТЕЛЬ
+        "\xd0\xb2\xd0\xbe\xd1\x88\xd1\x91\xd0\xbb",                                    // вошёл
+        "\xd0\xb2", "\xd1\x81\xd0\xb8\xd1\x81\xd1\x82\xd0\xb5\xd0\xbc\xd1\x83",          // в систему
+        "\xd0\x97\xd0\xb0\xd0\xbf\xd1\x80\xd0\xbe\xd1\x81",                            // Запрос
+        "\xd0\xb2\xd1\x8b\xd0\xbf\xd0\xbe\xd0\xbb\xd0\xbd\xd0\xb5\xd0\xbd",              // выполнен
+        "\xe2\x80\x94", "INFO", "WARN", "user_id=42", "GET", "/api/v1/orders", "200", "ms"};
+    std::mt19937_64 rng(777);
+    std::uniform_int_distribution<std::size_t> word_dist(0, words.size() - 1);
+    std::uniform_int_distribution<int> line_dist(0, 11);
+    std::string text;
+    text.reserve(bytes + 64);
+    while (text.size() < bytes) {
+        text += words[word_dist(rng)];
+        text.push_back(line_dist(rng) == 0 ? '\n' : ' ');
+    }
+    return text;
+}
+
+bool is_ascii(std::string_view text) {
+    return std::all_of(text.begin(), text.end(), [](char c) { return static_cast<unsigned char>(c) < 0x80; });
+}
+
+int bench_tokenizer(const BenchConfig& cfg) {
+    std::uint64_t total_bytes = 0;
+    const std::vector<fs::path> files = list_files(cfg.input_dir, total_bytes);
+    std::vector<std::string> contents;
+    for (const auto& path : files) {
+        contents.push_back(read_all(path));
+    }
+    std::cout << "Files: " << files.size() << ", " << total_bytes / (1024 * 1024) << " MiB\n";
+
+    auto scalar = [](auto&&... args) { tokenize_scalar(std::forward<decltype(args)>(args)...); };
+    auto simd = [](auto&&... args) { tokenize_simd(std::forward<decltype(args)>(args)...); };
+    auto utf8_scalar = [](auto&&... args) { tokenize_utf8_scalar(std::forward<decltype(args)>(args)...); };
+    auto utf8 = [](auto&&... args) { tokenize_utf8(std::forward<decltype(args)>(args)...); };
+
+    bool ok = differential_check(20000);
+    bool utf8_ok = utf8_differential_check(20000);
+    for (const auto& text : contents) {
+        ok = ok && collect_tokens(scalar, text, cfg.minlen) == collect_tokens(simd, text, cfg.minlen);
+        utf8_ok = utf8_ok && collect_tokens(utf8_scalar, text, cfg.minlen) == collect_tokens(utf8, text, cfg.minlen);
+        // На чистом ASCII режим UTF-8 обязан давать те же слова.
+        if (is_ascii(text)) {
+            utf8_ok = utf8_ok && collect_tokens(simd, text, cfg.minlen) == collect_tokens(utf8, text, cfg.minlen);
+        }
+    }
+
+    // Возвращает пропускную способность, GB/s.
+    auto measure = [&](const char* name, const std::vector<std::string>& texts, std::uint64_t bytes,
+                       auto tokenize_fn) {
+        std::uint64_t tokens = 0;
+        std::uint64_t checksum = 0;
+        const double seconds = best_of(cfg.repeat, [&] {
+            tokens = 0;
+            checksum = 0;
+            std::string scratch;
+            for (const auto& text : texts) {
+                tokenize_fn(text, cfg.minlen, scratch, [&](std::string_view word) {
+                    ++tokens;
+                    checksum += static_cast<unsigned char>(word.back()) + word.size();
+                });
+            }
+        });
+        const double gbps = static_cast<double>(bytes) / 1e9 / seconds;
+        std::cout << std::left << std::setw(16) << name << std::right
+                  << std::setw(10) << std::fixed << std::setprecision(3) << seconds << " s"
+                  << std::setw(10) << std::setprecision(2) << gbps << " GB/s  "
+                  << tokens << " tokens, checksum " << checksum << '\n';
+        return gbps;
+    };
+    measure("scalar", contents, total_bytes, scalar);
+    const double simd_gbps = measure("simd", contents, total_bytes, simd);
+    const double utf8_gbps = measure("utf8", contents, total_bytes, utf8);
+    std::cout << "utf8 / simd: " << std::setprecision(1) << 100.0 * utf8_gbps / simd_gbps << "%\n";
+
+    // Кириллица: посимвольный разбор против блочного с ASCII-проверкой.
+    const std::vector<std::string> cyrillic = {
+        make_cyrillic_log(static_cast<std::size_t>(std::max<std::uint64_t>(total_bytes, 1024 * 1024)))};
+    std::cout << "Cyrillic log: " << cyrillic.front().size() / (1024 * 1024) << " MiB\n";
+    utf8_ok = utf8_ok &&
+              collect_tokens(utf8_scalar, cyrillic.front(), cfg.minlen) == collect_tokens(utf8, cyrillic.front(), cfg.minlen);
+    measure("utf8-scalar", cyrillic, cyrillic.front().size(), utf8_scalar);
+    measure("utf8", cyrillic, cyrillic.front().size(), utf8);
+
+    if (!ok) {
+        std::cerr << "Error: SIMD tokenizer differs from the scalar one\n";
+        return 1;
+    }
+    if (!utf8_ok) {
+        std::cerr << "Error: UTF-8 tokenizer differs from the reference\n";
+        return 1;
+    }
+    std::cout << "Differential check: ok\n";
+    return 0;
+}
+
+// Пиковый RSS текущего процесса (VmHWM), KiB.
+std::uint64_t peak_rss_kib() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stoull(line.substr(6));
+        }
+    }
+    return 0;
+}
+
+// Каждый вариант считается в отдельном дочернем процессе, чтобы пиковый
+// RSS не смешивался. Файлы читаются через ifstream: страницы mmap тоже
+// попали бы в RSS.
+int bench_table(const BenchConfig& cfg) {
+    std::uint64_t total_bytes = 0;
+    const std::vector<fs::path> files = list_files(cfg.input_dir, total_bytes);
+    std::cout << "Files: " << files.size() << ", " << total_bytes / (1024 * 1024) << " MiB\n";
+
+    auto run_variant = [&](const char* name, auto counts) {
+        std::cout.flush();
+        const pid_t pid = ::fork();
+        if (pid < 0) {
+            throw std::runtime_error("fork failed");
+        }
+        if (pid == 0) {
+            const double seconds = best_of(1, [&] {
+                for (const auto& path : files) {
+                    process_file(path, IoMode::Stream, cfg.minlen, Encoding::Ascii, counts);
+                }
+            });
+            print_row(name, seconds, total_bytes,
+                      std::to_string(counts.size()) + " words, peak RSS " +
+                      std::to_string(peak_rss_kib() / 1024) + " MiB");
+            std::cout.flush();
+            std::_Exit(0);
+        }
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    };
+
+    bool ok = run_variant("unordered_map", WordMap());
+    ok = run_variant("flat+arena", WordTable()) && ok;
+    return ok ? 0 : 1;
+}
+
+struct SweepRow {
+    std::string variant;
+    std::size_t threads = 0;
+    double seconds = 0;
+    double mb_per_s = 0;
+    double speedup = 0;  // относительно 1 потока того же варианта
+    std::uint64_t peak_rss_kib = 0;
+    std::size_t words = 0;
+};
+
+void write_sweep_csv(const fs::path& path, const std::string& corpus, const std::vector<SweepRow>& rows) {
+    std::ofstream out(path);
+    out << "corpus,variant,threads,seconds,mb_per_s,speedup,peak_rss_mib,words\n";
+    out << std::fixed << std::setprecision(4);
+    for (const auto& row : rows) {
+        out << corpus << ',' << row.variant << ',' << row.threads << ',' << row.seconds << ','
+            << row.mb_per_s << ',' << row.speedup << ',' << row.peak_rss_kib / 1024.0 << ','
+            << row.words << '\n';
+    }
+    if (!out) {
+        throw std::runtime_error("Failed to write " + path.string());
+    }
+}
+
+void write_sweep_json(const fs::path& path,
+                      const std::string& corpus,
+                      std::uint64_t total_bytes,
+                      const std::vector<SweepRow>& rows) {
+    std::ofstream out(path);
+    out << std::fixed << std::setprecision(4);
+    out << "{\n  \"corpus\": \"" << corpus << "\",\n  \"bytes\": " << total_bytes << ",\n  \"runs\": [\n";
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        const auto& row = rows[i];
+        out << "    {\"variant\": \"" << row.variant << "\", \"threads\": " << row.threads
+            << ", \"seconds\": " << row.seconds << ", \"mb_per_s\": " << row.mb_per_s
+            << ", \"speedup\": " << row.speedup << ", \"peak_rss_mib\": " << row.peak_rss_kib / 1024.0
+            << ", \"words\": " << row.words << '}' << (i + 1 < rows.size() ? "," : "") << '\n';
+    }
+    out << "  ]\n}\n";
+    if (!out) {
+        throw std::runtime_error("Failed to write " + path.string());
+    }
+}
+
+// Стратегии синхронизации x число потоков. Каждая точка считается в
+// отдельном процессе (как в table), результат возвращается через pipe.
+// Чтение — ifstream, чтобы страницы mmap не попадали в пиковый RSS.
+int bench_sweep(const BenchConfig& cfg) {
+    struct Variant {
+        std::string name;
+        MergeStrategy strategy;
+        FlushPolicy flush;
+    };
+    const std::vector<Variant> variants = {
+        {"single", MergeStrategy::Single, {}},
+        {"single/file", MergeStrategy::Single, {1, 0}},
+        {"sharded", MergeStrategy::Sharded, {}},
+        {"sharded/file", MergeStrategy::Sharded, {1, 0}},
+    };
+    struct Measurement {
+        double seconds;
+        std::uint64_t peak_rss_kib;
+        std::uint64_t words;
+    };
+
+    std::uint64_t total_bytes = 0;
+    const std::vector<fs::path> files = list_files(cfg.input_dir, total_bytes);
+    const std::string corpus = fs::absolute(cfg.input_dir).lexically_normal().filename().string();
+    std::cout << "Corpus: " << corpus << ", files: " << files.size() << ", "
+              << total_bytes / (1024 * 1024) << " MiB\n";
+
+    auto measure = [&](const Variant& variant, std::size_t threads) {
+        int fds[2];
+        if (::pipe(fds) != 0) {
+            throw std::runtime_error("pipe failed");
+        }
+        std::cout.flush();
+        const pid_t pid = ::fork();
+        if (pid < 0) {
+            throw std::runtime_error("fork failed");
+        }
+        if (pid == 0) {
+            ::close(fds[0]);
+            IndexerOptions options;
+            options.threads = threads;
+            options.minlen = cfg.minlen;
+            options.io = IoMode::Stream;
+            options.flush = variant.flush;
+            std::uint64_t words = 0;
+            const double seconds = best_of(cfg.repeat, [&] {
+                GlobalCounts global(variant.strategy, cfg.shards);
+                run_indexer(options, cfg.input_dir, global);
+                words = global.size();
+            });
+            const Measurement result{seconds, peak_rss_kib(), words};
+            const bool written = ::write(fds[1], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result));
+            std::_Exit(written ? 0 : 1);
+        }
+        ::close(fds[1]);
+        Measurement result{};
+        const bool read_ok = ::read(fds[0], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result));
+        ::close(fds[0]);
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        if (!read_ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            throw std::runtime_error("sweep child failed: " + variant.name);
+        }
+        return result;
+    };
+
+    std::vector<SweepRow> rows;
+    for (const auto& variant : variants) {
+        double base_seconds = 0;
+        for (std::size_t threads : thread_sweep(cfg.threads)) {
+            const Measurement m = measure(variant, threads);
+            if (threads == 1) {
+                base_seconds = m.seconds;
+            }
+            SweepRow row;
+            row.variant = variant.name;
+            row.threads = threads;
+            row.seconds = m.seconds;
+            row.mb_per_s = m.seconds > 0 ? total_bytes / 1e6 / m.seconds : 0;
+            row.speedup = base_seconds > 0 && m.seconds > 0 ? base_seconds / m.seconds : 0;
+            row.peak_rss_kib = m.peak_rss_kib;
+            row.words = static_cast<std::size_t>(m.words);
+
+            std::ostringstream note;
+            note << "x" << std::fixed << std::setprecision(2) << row.speedup << ", peak RSS "
+                 << row.peak_rss_kib / 1024 << " MiB";
+            print_row("  " + variant.name + " t=" + std::to_string(threads), m.seconds, total_bytes, note.str());
+            rows.push_back(row);
+        }
+    }
+
+    // Все варианты обязаны насчитать один и тот же словарь.
+    for (const auto& row : rows) {
+        if (row.words != rows.front().words) {
+            std::cerr << "Error: " << row.variant << " t=" << row.threads << " found " << row.words
+                      << " words, expected " << rows.front().words << '\n';
+            return 1;
+        }
+    }
+
+    if (!cfg.csv_path.empty()) {
+        write_sweep_csv(cfg.csv_path, corpus, rows);
+    }
+    if (!cfg.json_path.empty()) {
+        write_sweep_json(cfg.json_path, corpus, total_bytes, rows);
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const BenchConfig cfg = parse_args(argc, argv);
+        if (!fs::is_directory(cfg.input_dir)) {
+            std::cerr << "Input path is not a directory: " << cfg.input_dir << '\n';
+            return 1;
+        }
+
+        if (cfg.suite == "io") {
+            return bench_io(cfg);
+        }
+        if (cfg.suite == "compressed") {
+            return bench_compressed(cfg);
+        }
+        if (cfg.suite == "merge") {
+            return bench_merge(cfg);
+        }
+        if (cfg.suite == "scheduler") {
+            return bench_scheduler(cfg);
+        }
+        if (cfg.suite == "topm") {
+            return bench_topm(cfg);
+        }
+        if (cfg.suite == "tokenizer") {
+            return bench_tokenizer(cfg);
+        }
+        if (cfg.suite == "table") {
+            return bench_table(cfg);
+        }
+        if (cfg.suite == "sweep") {
+            return bench_sweep(cfg);
+        }
+
+        std::cerr << "Unknown suite: " << cfg.suite << '\n';
+        print_usage(argv[0]);
+        return 1;
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << '\n';
+        return 1;
+    }
+}
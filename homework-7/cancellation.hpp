@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <pthread.h>
+#include <signal.h>
+
+// Кооперативная отмена. Кто умеет останавливаться (очереди задач),
+// подписывается на request(); остальные проверяют requested().
+class Cancellation {
+public:
+    bool requested() const noexcept {
+        return requested_.load();
+    }
+
+    // Вызывает обработчики один раз; повторные запросы ничего не делают.
+    void request() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (requested_.exchange(true)) {
+            return;
+        }
+        for (auto& [id, handler] : handlers_) {
+            handler();
+        }
+    }
+
+    // Подписка на время жизни объекта. Если отмена уже запрошена,
+    // обработчик вызывается сразу.
+    class Subscription {
+    public:
+        Subscription(Cancellation* owner, std::function<void()> handler) : owner_(owner) {
+            if (owner_ != nullptr) {
+                id_ = owner_->subscribe(std::move(handler));
+            }
+        }
+
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+
+        ~Subscription() {
+            if (owner_ != nullptr) {
+                owner_->unsubscribe(id_);
+            }
+        }
+
+    private:
+        Cancellation* owner_;
+        std::size_t id_{0};
+    };
+
+private:
+    std::size_t subscribe(std::function<void()> handler) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (requested_.load()) {
+            handler();
+        }
+        handlers_.emplace(++last_id_, std::move(handler));
+        return last_id_;
+    }
+
+    void unsubscribe(std::size_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handlers_.erase(id);
+    }
+
+    std::atomic<bool> requested_{false};
+    std::mutex mutex_;
+    std::map<std::size_t, std::function<void()>> handlers_;
+    std::size_t last_id_{0};
+};
+
+// Превращает SIGINT/SIGTERM в Cancellation::request(). Сигналы блокируются
+// в создающем потоке (и во всех, что он запустит позже), а принимает их
+// отдельный поток через sigtimedwait — обработчики отмены выполняются в
+// обычном контексте, а не в async-signal. Второй сигнал завершает процесс
+// сразу.
+class SignalWatcher {
+public:
+    explicit SignalWatcher(Cancellation& cancellation) {
+        sigemptyset(&signals_);
+        sigaddset(&signals_, SIGINT);
+        sigaddset(&signals_, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals_, &previous_);
+
+        thread_ = std::thread([this, &cancellation] {
+            const timespec poll{0, 100 * 1000 * 1000};
+            while (!stopped_.load()) {
+                const int signal = sigtimedwait(&signals_, nullptr, &poll);
+                if (signal < 0) {
+                    continue;
+                }
+                if (cancellation.requested()) {
+                    std::_Exit(128 + signal);
+                }
+                cancellation.request();
+            }
+        });
+    }
+
+    SignalWatcher(const SignalWatcher&) = delete;
+    SignalWatcher& operator=(const SignalWatcher&) = delete;
+
+    ~SignalWatcher() {
+        stopped_.store(true);
+        thread_.join();
+        pthread_sigmask(SIG_SETMASK, &previous_, nullptr);
+    }
+
+private:
+    sigset_t signals_{};
+    sigset_t previous_{};
+    std::atomic<bool> stopped_{false};
+    std::thread thread_;
+};
@@ -0,0 +1,457 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(HOMEWORK7_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+#if defined(HOMEWORK7_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+#include "tokenizer.hpp"
+
+enum class Compression {
+    None,
+    Gzip,
+    Zstd,
+};
+
+inline const char* compression_name(Compression compression) {
+    switch (compression) {
+        case Compression::Gzip:
+            return "gzip";
+        case Compression::Zstd:
+            return "zstd";
+        default:
+            return "none";
+    }
+}
+
+// Формат определяется по магическим байтам, а не по расширению.
+inline Compression compression_of(std::string_view head) {
+    if (head.size() >= 2 && head[0] == '\x1f' && head[1] == '\x8b') {
+        return Compression::Gzip;
+    }
+    if (head.size() >= 4 && head.substr(0, 4) == std::string_view("\x28\xb5\x2f\xfd", 4)) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+inline Compression detect_compression(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    char head[4] = {};
+    file.read(head, sizeof(head));
+    return compression_of(std::string_view(head, static_cast<std::size_t>(file.gcount())));
+}
+
+inline bool compression_supported(Compression compression) {
+    switch (compression) {
+        case Compression::None:
+            return true;
+        case Compression::Gzip:
+#if defined(HOMEWORK7_HAVE_ZLIB)
+            return true;
+#else
+            return false;
+#endif
+        case Compression::Zstd:
+#if defined(HOMEWORK7_HAVE_ZSTD)
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+// Потоковый распаковщик: read заполняет до cap байт и возвращает 0 в конце
+// данных. Повреждённый или обрезанный поток — исключение, но не сразу:
+// сначала read отдаёт всё, что успел распаковать, а бросает следующий вызов.
+class Decompressor {
+public:
+    virtual ~Decompressor() = default;
+
+    std::size_t read(char* dst, std::size_t cap) {
+        if (!error_.empty()) {
+            throw std::runtime_error(error_);
+        }
+        const std::size_t got = decode(dst, cap);
+        if (got == 0 && !error_.empty()) {
+            throw std::runtime_error(error_);
+        }
+        return got;
+    }
+
+protected:
+    // Как read, но об ошибке сообщает через fail и возвращает то, что
+    // распаковано до неё.
+    virtual std::size_t decode(char* dst, std::size_t cap) = 0;
+
+    void fail(std::string message) {
+        error_ = std::move(message);
+    }
+
+private:
+    std::string error_;
+};
+
+namespace detail {
+
+constexpr std::size_t kCompressedReadSize = 256 * 1024;
+
+#if defined(HOMEWORK7_HAVE_ZLIB)
+// gzip, включая несколько склеенных членов (cat a.gz b.gz).
+class GzipDecompressor final : public Decompressor {
+public:
+    explicit GzipDecompressor(const std::filesystem::path& path)
+        : file_(path, std::ios::binary), input_(kCompressedReadSize) {
+        if (!file_) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+        // 15 + 32: окно 32 KiB, заголовок gzip или zlib определяется сам.
+        if (inflateInit2(&stream_, 15 + 32) != Z_OK) {
+            throw std::runtime_error("inflateInit2 failed");
+        }
+    }
+
+    ~GzipDecompressor() override {
+        inflateEnd(&stream_);
+    }
+
+private:
+    std::size_t decode(char* dst, std::size_t cap) override {
+        stream_.next_out = reinterpret_cast<Bytef*>(dst);
+        stream_.avail_out = static_cast<uInt>(cap);
+        while (stream_.avail_out > 0) {
+            if (stream_.avail_in == 0) {
+                file_.read(input_.data(), static_cast<std::streamsize>(input_.size()));
+                const auto got = static_cast<uInt>(file_.gcount());
+                if (got == 0) {
+                    if (in_member_) {
+                        fail("truncated gzip stream");
+                    }
+                    break;
+                }
+                stream_.next_in = reinterpret_cast<Bytef*>(input_.data());
+                stream_.avail_in = got;
+            }
+
+            const int rc = inflate(&stream_, Z_NO_FLUSH);
+            if (rc == Z_STREAM_END) {
+                in_member_ = false;
+                inflateReset(&stream_);
+                continue;
+            }
+            if (rc != Z_OK) {
+                fail(std::string("corrupted gzip stream: ") + (stream_.msg != nullptr ? stream_.msg : "inflate failed"));
+                break;
+            }
+            in_member_ = true;
+        }
+        return cap - stream_.avail_out;
+    }
+
+    std::ifstream file_;
+    std::vector<char> input_;
+    z_stream stream_{};
+    bool in_member_{false};
+};
+#endif
+
+#if defined(HOMEWORK7_HAVE_ZSTD)
+// zstd, включая несколько склеенных кадров.
+class ZstdDecompressor final : public Decompressor {
+public:
+    explicit ZstdDecompressor(const std::filesystem::path& path)
+        : file_(path, std::ios::binary), input_(ZSTD_DStreamInSize()), context_(ZSTD_createDCtx()) {
+        if (!file_) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+        if (context_ == nullptr) {
+            throw std::runtime_error("ZSTD_createDCtx failed");
+        }
+    }
+
+    ~ZstdDecompressor() override {
+        ZSTD_freeDCtx(context_);
+    }
+
+private:
+    std::size_t decode(char* dst, std::size_t cap) override {
+        ZSTD_outBuffer out{dst, cap, 0};
+        while (out.pos < out.size) {
+            if (in_.pos == in_.size && !eof_) {
+                file_.read(input_.data(), static_cast<std::streamsize>(input_.size()));
+                in_ = ZSTD_inBuffer{input_.data(), static_cast<std::size_t>(file_.gcount()), 0};
+                eof_ = in_.size == 0;
+            }
+
+            const std::size_t out_before = out.pos;
+            const std::size_t in_before = in_.pos;
+            const std::size_t rc = ZSTD_decompressStream(context_, &out, &in_);
+            if (ZSTD_isError(rc) != 0) {
+                fail(std::string("corrupted zstd stream: ") + ZSTD_getErrorName(rc));
+                break;
+            }
+            // 0 — кадр закончен. Вызов без продвижения возвращает лишь
+            // подсказку о размере следующего входа, её не учитываем.
+            const bool progressed = out.pos != out_before || in_.pos != in_before;
+            if (progressed) {
+                frame_left_ = rc;
+            }
+            // Вход кончился, а распаковщику больше нечего отдать.
+            if (eof_ && !progressed) {
+                if (frame_left_ != 0) {
+                    fail("truncated zstd stream");
+                }
+                break;
+            }
+        }
+        return out.pos;
+    }
+
+    std::ifstream file_;
+    std::vector<char> input_;
+    ZSTD_DCtx* context_;
+    ZSTD_inBuffer in_{nullptr, 0, 0};
+    std::size_t frame_left_{0};
+    bool eof_{false};
+};
+#endif
+
+// Ограниченная очередь распакованных блоков между стадией распаковки и
+// токенизатором. Пустые буферы возвращаются обратно, чтобы не выделять
+// память на каждый блок.
+class BlockChannel {
+public:
+    explicit BlockChannel(std::size_t capacity) : capacity_(capacity) {}
+
+    // false — потребитель отменил чтение, дальше распаковывать незачем.
+    bool push(std::string block) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        room_.wait(lock, [this] { return full_.size() < capacity_ || cancelled_; });
+        if (cancelled_) {
+            return false;
+        }
+        full_.push(std::move(block));
+        ready_.notify_one();
+        return true;
+    }
+
+    bool pop(std::string& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return !full_.empty() || closed_; });
+        if (full_.empty()) {
+            return false;
+        }
+        out = std::move(full_.front());
+        full_.pop();
+        room_.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        ready_.notify_all();
+    }
+
+    // Потребитель уходит раньше времени: продюсер не должен повиснуть в push.
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        room_.notify_all();
+    }
+
+    void recycle(std::string block) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(std::move(block));
+    }
+
+    std::string take_free() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.empty()) {
+            return std::string();
+        }
+        std::string block = std::move(free_.back());
+        free_.pop_back();
+        return block;
+    }
+
+private:
+    std::size_t capacity_;
+    std::queue<std::string> full_;
+    std::vector<std::string> free_;
+    bool closed_{false};
+    bool cancelled_{false};
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::condition_variable room_;
+};
+
+constexpr std::size_t kDecodedBlockSize = 1024 * 1024;
+constexpr std::size_t kDecodedBlocksInFlight = 4;
+
+// Распаковывает поток блоками и отдаёт их в emit(std::string&&), пока тот
+// возвращает true. Каждый блок обрезан по последнему ASCII-разделителю, остаток
+// переносится в начало следующего, так что слова не разрываются между
+// блоками. Если разделителя в блоке нет, следующий кусок дочитывается в
+// тот же буфер с удвоением ёмкости: слово длиннее блока не режется, а
+// прочитанное не копируется заново на каждом куске.
+// fresh_block() выдаёт буфер под очередной блок. При ошибке
+// распаковки перенесённый остаток тоже отдаётся, а исключение летит дальше.
+template <typename Emit, typename Fresh>
+void decode_blocks(Decompressor& source, Fresh&& fresh_block, Emit&& emit) {
+    std::string carry;
+    while (true) {
+        std::string block = fresh_block();
+        block.assign(carry);
+        std::size_t cut = 0;
+        while (cut == 0) {
+            // До filled — перенос и прочитанное раньше, разделителей там нет.
+            const std::size_t filled = block.size();
+            if (block.capacity() < filled + kDecodedBlockSize) {
+                block.reserve(std::max(2 * block.capacity(), filled + kDecodedBlockSize));
+            }
+            block.resize(filled + kDecodedBlockSize);
+            std::size_t got = 0;
+            try {
+                got = source.read(block.data() + filled, kDecodedBlockSize);
+            } catch (...) {
+                block.resize(filled);
+                if (!block.empty()) {
+                    emit(std::move(block));
+                }
+                throw;
+            }
+            block.resize(filled + got);
+            if (got == 0) {
+                if (!block.empty()) {
+                    emit(std::move(block));
+                }
+                return;
+            }
+
+            cut = block.size();
+            while (cut > filled && !is_separator_byte(static_cast<unsigned char>(block[cut - 1]))) {
+                --cut;
+            }
+            if (cut == filled) {
+                cut = 0;
+            }
+        }
+        carry.assign(block, cut, std::string::npos);
+        block.resize(cut);
+        if (!emit(std::move(block))) {
+            return;
+        }
+    }
+}
+
+inline std::unique_ptr<Decompressor> open_decompressor(const std::filesystem::path& path,
+                                                       Compression compression) {
+    switch (compression) {
+#if defined(HOMEWORK7_HAVE_ZLIB)
+        case Compression::Gzip:
+            return std::make_unique<GzipDecompressor>(path);
+#endif
+#if defined(HOMEWORK7_HAVE_ZSTD)
+        case Compression::Zstd:
+            return std::make_unique<ZstdDecompressor>(path);
+#endif
+        default:
+            throw std::runtime_error(std::string("built without ") + compression_name(compression) + " support");
+    }
+}
+
+}  // namespace detail
+
+// Считает слова сжатого файла целиком. При pipelined распаковка идёт в
+// отдельном потоке и опережает токенизатор на несколько блоков; иначе
+// блоки распаковываются и разбираются по очереди в текущем потоке.
+// Возвращает число распакованных байт. Ошибки формата не прерывают
+// индексацию: учитывается всё, что удалось распаковать, и печатается
+// предупреждение.
+template <typename Sink>
+std::uint64_t process_compressed(const std::filesystem::path& path,
+                                 Compression compression,
+                                 std::size_t minlen,
+                                 Encoding encoding,
+                                 Sink&& sink,
+                                 bool pipelined = true) {
+    std::uint64_t processed = 0;
+    std::string scratch;
+    auto consume = [&](const std::string& block) {
+        processed += block.size();
+        tokenize(block, minlen, encoding, scratch, sink);
+    };
+
+    std::string error;
+    try {
+        const std::unique_ptr<Decompressor> source = detail::open_decompressor(path, compression);
+        if (!pipelined) {
+            std::string reuse;
+            detail::decode_blocks(
+                *source, [&reuse] { return std::move(reuse); },
+                [&](std::string&& block) {
+                    consume(block);
+                    reuse = std::move(block);
+                    return true;
+                });
+        } else {
+            detail::BlockChannel channel(detail::kDecodedBlocksInFlight);
+            std::exception_ptr decode_error;
+            std::thread decoder([&] {
+                try {
+                    detail::decode_blocks(
+                        *source, [&channel] { return channel.take_free(); },
+                        [&channel](std::string&& block) { return channel.push(std::move(block)); });
+                } catch (...) {
+                    decode_error = std::current_exception();
+                }
+                channel.close();
+            });
+
+            std::string block;
+            try {
+                while (channel.pop(block)) {
+                    consume(block);
+                    channel.recycle(std::move(block));
+                }
+            } catch (...) {
+                channel.cancel();
+                decoder.join();
+                throw;
+            }
+            decoder.join();
+            if (decode_error) {
+                std::rethrow_exception(decode_error);
+            }
+        }
+    } catch (const std::exception& ex) {
+        error = ex.what();
+    }
+
+    if (!error.empty()) {
+        std::cerr << "Warning: " << path.string() << ": " << error << '\n';
+    }
+    return processed;
+}
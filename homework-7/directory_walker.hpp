@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Порядок, в котором producer отдаёт задачи workers.
+enum class TaskOrder {
+    Discovery,     // как нашлись при обходе, задачи идут сразу
+    LargestFirst,  // по убыванию размера после полного обхода
+};
+
+inline TaskOrder parse_task_order(const std::string& name) {
+    if (name == "discovery") {
+        return TaskOrder::Discovery;
+    }
+    if (name == "largest") {
+        return TaskOrder::LargestFirst;
+    }
+    throw std::runtime_error("Unknown --order: " + name + " (expected discovery|largest)");
+}
+
+inline const char* task_order_name(TaskOrder order) {
+    return order == TaskOrder::LargestFirst ? "largest" : "discovery";
+}
+
+struct WalkOptions {
+    bool recursive = false;
+    std::size_t threads = 1;
+};
+
+namespace detail {
+
+// Общий стек каталогов для параллельного обхода. Обход закончен, когда
+// стек пуст и ни один поток не читает каталог (из него могли бы
+// появиться новые).
+class DirectoryStack {
+public:
+    explicit DirectoryStack(std::filesystem::path root) {
+        pending_.push_back(std::move(root));
+    }
+
+    bool pop(std::filesystem::path& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !pending_.empty() || active_ == 0; });
+        if (pending_.empty()) {
+            return false;
+        }
+        out = std::move(pending_.back());
+        pending_.pop_back();
+        ++active_;
+        return true;
+    }
+
+    // Завершает каталог, взятый pop, и добавляет найденные в нём подкаталоги.
+    void done(std::vector<std::filesystem::path>& subdirs) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& dir : subdirs) {
+                pending_.push_back(std::move(dir));
+            }
+            --active_;
+        }
+        subdirs.clear();
+        cv_.notify_all();
+    }
+
+private:
+    std::vector<std::filesystem::path> pending_;
+    std::size_t active_{0};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+// Читает один каталог: файлы отдаёт в sink, подкаталоги (при recursive)
+// складывает в subdirs. Ошибка открытия корня бросает исключение,
+// остальные каталоги без прав на чтение просто пропускаются.
+template <typename Sink>
+void scan_directory(const std::filesystem::path& dir,
+                    bool is_root,
+                    bool recursive,
+                    Sink& sink,
+                    std::vector<std::filesystem::path>& subdirs) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec);
+    if (ec && is_root) {
+        throw fs::filesystem_error("Failed to read directory", dir, ec);
+    }
+    for (const fs::directory_iterator end; !ec && it != end; it.increment(ec)) {
+        const fs::directory_entry& entry = *it;
+        if (entry.is_regular_file(ec)) {
+            const std::uint64_t size = entry.file_size(ec);
+            if (!ec) {
+                sink(entry.path(), size);
+            }
+        } else if (recursive && entry.is_directory(ec) && !entry.is_symlink(ec)) {
+            subdirs.push_back(entry.path());
+        }
+        // Файл мог исчезнуть между чтением каталога и stat — не повод
+        // прерывать обход.
+        ec.clear();
+    }
+}
+
+}  // namespace detail
+
+// Вызывает sink(path, size) для каждого обычного файла в root (и во
+// вложенных каталогах при options.recursive). При options.threads > 1
+// каталоги читаются параллельно, и sink вызывается из нескольких потоков.
+// Символические ссылки на каталоги не обходятся.
+template <typename Sink>
+void walk_directory(const std::filesystem::path& root, const WalkOptions& options, Sink&& sink) {
+    namespace fs = std::filesystem;
+    detail::DirectoryStack stack(root);
+
+    // Корень читается в вызывающем потоке, чтобы ошибка его открытия ушла
+    // наверх исключением.
+    fs::path dir;
+    std::vector<fs::path> subdirs;
+    stack.pop(dir);
+    detail::scan_directory(dir, true, options.recursive, sink, subdirs);
+    stack.done(subdirs);
+
+    auto walk = [&stack, &options, &sink] {
+        fs::path next;
+        std::vector<fs::path> found;
+        while (stack.pop(next)) {
+            detail::scan_directory(next, false, options.recursive, sink, found);
+            stack.done(found);
+        }
+    };
+
+    std::vector<std::thread> walkers;
+    const std::size_t threads = std::max<std::size_t>(1, options.threads);
+    walkers.reserve(threads - 1);
+    for (std::size_t i = 1; i < threads; ++i) {
+        walkers.emplace_back(walk);
+    }
+    walk();
+    for (auto& walker : walkers) {
+        walker.join();
+    }
+}
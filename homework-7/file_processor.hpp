@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "compressed_input.hpp"
+#include "mapped_file.hpp"
+#include "task_queue.hpp"
+#include "tokenizer.hpp"
+#include "word_table.hpp"
+
+// Исходный контейнер частот; оставлен для сравнения с WordTable.
+using WordMap = std::unordered_map<std::string, std::uint64_t>;
+
+enum class IoMode {
+    Stream,
+    Mmap,
+};
+
+inline IoMode parse_io_mode(const std::string& name) {
+    if (name == "stream") {
+        return IoMode::Stream;
+    }
+    if (name == "mmap") {
+        return IoMode::Mmap;
+    }
+    throw std::runtime_error("Unknown --io mode: " + name + " (expected stream|mmap)");
+}
+
+inline const char* io_mode_name(IoMode mode) {
+    return mode == IoMode::Mmap ? "mmap" : "stream";
+}
+
+inline void count_word(WordTable& counts, std::string_view word, std::string&) {
+    counts.increment(word);
+}
+
+// Ключ материализуется в std::string только при вставке нового слова:
+// поиск идёт через переиспользуемый буфер key.
+inline void count_word(WordMap& counts, std::string_view word, std::string& key) {
+    key.assign(word.data(), word.size());
+    ++counts[key];
+}
+
+template <typename Counts>
+class WordCounter {
+public:
+    explicit WordCounter(Counts& counts) : counts_(counts) {
+        key_.reserve(64);
+    }
+
+    void operator()(std::string_view word) {
+        count_word(counts_, word, key_);
+    }
+
+private:
+    Counts& counts_;
+    std::string key_;
+};
+
+// Функции process_* возвращают количество обработанных байт.
+template <typename Counts>
+std::uint64_t process_stream(const Task& task,
+                             std::size_t minlen,
+                             Encoding encoding,
+                             Counts& local_counts) {
+    std::ifstream file(task.path);
+    if (!file) {
+        return 0;
+    }
+    if (task.offset > 0 && !file.seekg(static_cast<std::streamoff>(task.offset))) {
+        return 0;
+    }
+
+    // Сжатый файл никогда не режется на чанки, так что проверять магию
+    // нужно только у задачи с начала файла.
+    if (task.offset == 0) {
+        char head[4] = {};
+        file.read(head, sizeof(head));
+        const Compression compression =
+            compression_of(std::string_view(head, static_cast<std::size_t>(file.gcount())));
+        if (compression != Compression::None) {
+            return process_compressed(task.path, compression, minlen, encoding, WordCounter<Counts>(local_counts));
+        }
+        file.clear();
+        file.seekg(0);
+    }
+
+    WordCounter<Counts> counter(local_counts);
+    std::string scratch;
+    std::string line;
+    std::uint64_t remaining = task.length;
+    std::uint64_t processed = 0;
+    while (remaining > 0 && std::getline(file, line)) {
+        if (line.size() >= remaining) {
+            line.resize(static_cast<std::size_t>(remaining));
+            remaining = 0;
+        } else {
+            remaining -= line.size() + 1;
+        }
+        processed += line.size() + 1;
+        tokenize(line, minlen, encoding, scratch, counter);
+    }
+    return processed;
+}
+
+template <typename Counts>
+std::uint64_t process_mmap(const Task& task,
+                           std::size_t minlen,
+                           Encoding encoding,
+                           Counts& local_counts) {
+    const MappedFile file(task.path);
+    if (!file) {
+        return 0;
+    }
+
+    const std::string_view data = file.view();
+    if (task.offset == 0) {
+        const Compression compression = compression_of(data.substr(0, 4));
+        if (compression != Compression::None) {
+            return process_compressed(task.path, compression, minlen, encoding, WordCounter<Counts>(local_counts));
+        }
+    }
+    const std::size_t offset = static_cast<std::size_t>(std::min<std::uint64_t>(task.offset, data.size()));
+    const std::size_t length = static_cast<std::size_t>(std::min<std::uint64_t>(task.length, data.size() - offset));
+
+    WordCounter<Counts> counter(local_counts);
+    std::string scratch;
+    tokenize(data.substr(offset, length), minlen, encoding, scratch, counter);
+    return length;
+}
+
+template <typename Counts>
+std::uint64_t process_file(const Task& task,
+                           IoMode mode,
+                           std::size_t minlen,
+                           Encoding encoding,
+                           Counts& local_counts) {
+    if (mode == IoMode::Mmap) {
+        return process_mmap(task, minlen, encoding, local_counts);
+    }
+    return process_stream(task, minlen, encoding, local_counts);
+}
+
+template <typename Counts>
+std::uint64_t process_file(const std::filesystem::path& file_path,
+                           IoMode mode,
+                           std::size_t minlen,
+                           Encoding encoding,
+                           Counts& local_counts) {
+    return process_file(Task{file_path}, mode, minlen, encoding, local_counts);
+}
+
+// Первая позиция не раньше offset, где стоит разделитель (или конец файла).
+// Граница чанка на разделителе гарантирует, что ни одно слово не будет
+// разрезано между двумя задачами. Разделитель — ASCII, так что граница
+// годится и для режима UTF-8.
+inline std::uint64_t find_chunk_boundary(std::ifstream& file, std::uint64_t offset) {
+    std::array<char, 4096> buffer{};
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(offset));
+
+    std::uint64_t pos = offset;
+    while (file) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        const auto got = static_cast<std::size_t>(file.gcount());
+        for (std::size_t i = 0; i < got; ++i) {
+            if (is_separator_byte(static_cast<unsigned char>(buffer[i]))) {
+                return pos + i;
+            }
+        }
+        pos += got;
+    }
+    return pos;
+}
+
+// Разбивает диапазон [begin, end) файла на задачи примерно по chunk_bytes
+// байт. chunk_bytes == 0 отключает разбиение, сжатые файлы тоже не
+// режутся — их поток читается только с начала. begin должен стоять на
+// границе слова (начало файла или позиция сразу после разделителя).
+template <typename Push>
+void split_range(const std::filesystem::path& path,
+                 std::uint64_t begin,
+                 std::uint64_t end,
+                 std::uint64_t chunk_bytes,
+                 Push&& push) {
+    std::ifstream file;
+    if (chunk_bytes != 0 && end - begin > chunk_bytes && detect_compression(path) == Compression::None) {
+        file.open(path, std::ios::binary);
+    }
+    if (!file.is_open()) {
+        push(Task{path, begin, end - begin});
+        return;
+    }
+
+    while (begin < end) {
+        const std::uint64_t next = end - begin > chunk_bytes
+            ? std::min(end, find_chunk_boundary(file, begin + chunk_bytes))
+            : end;
+        push(Task{path, begin, next - begin});
+        begin = next;
+    }
+}
+
+template <typename Push>
+void split_file(const std::filesystem::path& path,
+                std::uint64_t file_size,
+                std::uint64_t chunk_bytes,
+                Push&& push) {
+    split_range(path, 0, file_size, chunk_bytes, std::forward<Push>(push));
+}
@@ -1,14 +1,18 @@
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <random>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 namespace fs = std::filesystem;
@@ -22,6 +26,7 @@ struct Args {
     uint64_t seed = 0;      // 0 => по времени
     int min_word_len = 3;
     int max_word_len = 12;
+    int threads = 0;        // 0 => hardware_concurrency
 };
 
 static void print_usage(const char* prog) {
@@ -36,6 +41,8 @@ static void print_usage(const char* prog) {
         "  --seed X          random seed, 0 = time-based (default: 0)\n"
         "  --minlen L        min generated word length (default: 3)\n"
         "  --maxlen L        max generated word length (default: 12)\n"
+        "  --threads N       files generated in parallel (default: all cores);\n"
+        "                    output for a given seed does not depend on N\n"
         "\nExamples:\n"
         "  " << prog << " --out data --files 100 --mib 20 --vocab 50000 --skew 1.3 --seed 42\n";
 }
@@ -74,6 +81,8 @@ static bool parse_args(int argc, char** argv, Args& a) {
             a.min_word_len = std::stoi(need("--minlen"));
         } else if (key == "--maxlen") {
             a.max_word_len = std::stoi(need("--maxlen"));
+        } else if (key == "--threads") {
+            a.threads = std::stoi(need("--threads"));
         } else {
             std::cerr << "Unknown option: " << key << "\n";
             print_usage(argv[0]);
@@ -88,6 +97,10 @@ static bool parse_args(int argc, char** argv, Args& a) {
         std::cerr << "Invalid minlen/maxlen\n";
         std::exit(2);
     }
+    if (a.threads < 0) {
+        std::cerr << "threads must be >= 0\n";
+        std::exit(2);
+    }
     return true;
 }
 
@@ -103,50 +116,208 @@ static std::string rand_word(std::mt19937_64& rng, int minlen, int maxlen) {
     return w;
 }
 
-static std::string maybe_mutate(std::mt19937_64& rng, const std::string& base) {
+// splitmix64: из общего seed и номера файла получаем независимый seed
+// потока, так что файл не зависит от того, какой поток и когда его пишет.
+static uint64_t mix_seed(uint64_t seed, uint64_t stream) {
+    uint64_t z = seed + (stream + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Alias-таблица (метод Уолкера/Воуза): выбор по весам за O(1) —
+// одна случайная колонка и одно сравнение, вместо бинарного поиска
+// discrete_distribution по накопленным весам.
+class AliasTable {
+public:
+    explicit AliasTable(const std::vector<double>& weights)
+        : prob_(weights.size(), 1.0), alias_(weights.size()) {
+        const size_t n = weights.size();
+        double sum = 0;
+        for (double w : weights) sum += w;
+
+        std::vector<double> scaled(n);
+        std::vector<uint32_t> small, large;
+        for (size_t i = 0; i < n; i++) {
+            scaled[i] = weights[i] * double(n) / sum;
+            alias_[i] = uint32_t(i);
+            (scaled[i] < 1.0 ? small : large).push_back(uint32_t(i));
+        }
+        while (!small.empty() && !large.empty()) {
+            uint32_t s = small.back();
+            small.pop_back();
+            uint32_t l = large.back();
+            prob_[s] = scaled[s];
+            alias_[s] = l;
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // Остатки (из-за погрешности double) — колонки с вероятностью 1.
+    }
+
+    size_t operator()(std::mt19937_64& rng) const {
+        uint64_t bits = rng();
+        size_t column = size_t(((bits >> 32) * prob_.size()) >> 32);
+        double coin = double(bits & 0xffffffffull) * (1.0 / 4294967296.0);
+        return coin < prob_[column] ? column : alias_[column];
+    }
+
+private:
+    std::vector<double> prob_;
+    std::vector<uint32_t> alias_;
+};
+
+static void append_mutated(std::mt19937_64& rng, const std::string& base, std::string& out) {
     // Добавляем "логовый" шум: цифры, _, Camel-ish, смесь
     std::uniform_int_distribution<int> p(0, 99);
     int x = p(rng);
-    if (x < 70) return base; // чаще без мутации
+    if (x < 70) { // чаще без мутации
+        out += base;
+        return;
+    }
 
-    std::string w = base;
+    size_t start = out.size();
+    out += base;
     if (x < 80) {
         // суффикс _123 или _ab12
         std::uniform_int_distribution<int> d(0, 9999);
-        w += "_";
-        w += std::to_string(d(rng));
+        out += "_";
+        out += std::to_string(d(rng));
     } else if (x < 90) {
         // вставка цифры внутрь
-        if (!w.empty()) {
-            std::uniform_int_distribution<size_t> pos(0, w.size() - 1);
+        if (!base.empty()) {
+            std::uniform_int_distribution<size_t> pos(0, base.size() - 1);
             std::uniform_int_distribution<int> dig(0, 9);
-            w.insert(w.begin() + static_cast<std::ptrdiff_t>(pos(rng)), char('0' + dig(rng)));
+            size_t at = start + pos(rng);
+            out.insert(out.begin() + static_cast<std::ptrdiff_t>(at), char('0' + dig(rng)));
         }
     } else {
         // "слегка" поменять регистр
-        if (!w.empty()) w[0] = char(std::toupper(static_cast<unsigned char>(w[0])));
+        if (!base.empty()) out[start] = char(std::toupper(static_cast<unsigned char>(out[start])));
     }
-    return w;
 }
 
-static std::string rand_ip(std::mt19937_64& rng) {
+static void append_ip(std::mt19937_64& rng, std::string& out) {
     std::uniform_int_distribution<int> b(1, 254);
-    std::ostringstream oss;
-    oss << b(rng) << "." << b(rng) << "." << b(rng) << "." << b(rng);
-    return oss.str();
+    for (int i = 0; i < 4; i++) {
+        if (i) out += '.';
+        out += std::to_string(b(rng));
+    }
 }
 
-static std::string rand_level(std::mt19937_64& rng) {
-    static const char* levels[] = {"INFO", "WARN", "ERROR", "DEBUG", "TRACE"};
-    // Смещаем вероятности: INFO чаще
-    std::discrete_distribution<int> d({50, 15, 12, 18, 5});
-    return levels[d(rng)];
+static void append_level(std::mt19937_64& rng, std::string& out) {
+    // Смещаем вероятности: INFO чаще (50/15/12/18/5 из 100)
+    std::uniform_int_distribution<int> d(0, 99);
+    int x = d(rng);
+    out += x < 50 ? "INFO" : x < 65 ? "WARN" : x < 77 ? "ERROR" : x < 95 ? "DEBUG" : "TRACE";
 }
 
-static std::string rand_punct(std::mt19937_64& rng) {
+static void append_punct(std::mt19937_64& rng, std::string& out) {
     static const char* p[] = {" ", " ", " ", " ", " ", " - ", " | ", " : ", " :: ", ", ", "; ", "  "};
     std::uniform_int_distribution<int> d(0, (int)(sizeof(p)/sizeof(p[0]) - 1));
-    return p[d(rng)];
+    out += p[d(rng)];
+}
+
+// Общие для всех файлов данные: словарь и таблица выбора слова.
+struct Corpus {
+    std::vector<std::string> vocab;
+    AliasTable pick_word;
+};
+
+// Пишет один файл ровно из bytes_target байт. Всё случайное берётся из
+// своего потока RNG, поэтому содержимое определяется только seed и fi.
+static bool generate_file(const Corpus& corpus, const fs::path& path, int fi,
+                          uint64_t seed, uint64_t bytes_target) {
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs) {
+        std::cerr << "Failed to open: " << path.string() << "\n";
+        return false;
+    }
+
+    std::mt19937_64 rng(mix_seed(seed, uint64_t(fi)));
+
+    // Параметры "лог-строки"
+    std::uniform_int_distribution<int> msg_words(6, 18);     // слов в сообщении
+    std::uniform_int_distribution<int> maybe_comma(0, 99);   // иногда вставлять пунктуацию
+    std::uniform_int_distribution<int> maybe_path(0, 99);    // иногда вставлять path-like токен
+    std::uniform_int_distribution<int> code_dist(100, 599);  // http-like codes
+    std::uniform_int_distribution<int> user_id(1, 2000000);
+
+    const auto& vocab = corpus.vocab;
+    const auto& pick_word = corpus.pick_word;
+
+    // Крупный буфер: файл пишется блоками по 4 MiB
+    const size_t flush_bytes = size_t(4) << 20;
+    std::string buffer;
+    buffer.reserve(flush_bytes + 4096);
+
+    uint64_t written = 0;
+    uint64_t base_ts = 1700000000ull + uint64_t(fi) * 12345ull; // псевдо-epoch
+
+    while (written < bytes_target) {
+        // Таймстемп + уровень + ip + код
+        uint64_t ts = base_ts + (written / 200); // слегка растёт
+        buffer += std::to_string(ts);
+        append_punct(rng, buffer);
+        append_level(rng, buffer);
+        append_punct(rng, buffer);
+        buffer += "ip=";
+        append_ip(rng, buffer);
+        append_punct(rng, buffer);
+        buffer += "code=";
+        buffer += std::to_string(code_dist(rng));
+        append_punct(rng, buffer);
+
+        int wc = msg_words(rng);
+        for (int i = 0; i < wc; i++) {
+            append_mutated(rng, vocab[pick_word(rng)], buffer);
+
+            if (maybe_path(rng) < 6) {
+                // /api/v1/<word>/<word>?id=123
+                append_punct(rng, buffer);
+                buffer += "/api/v1/";
+                buffer += vocab[pick_word(rng)];
+                buffer += "/";
+                buffer += vocab[pick_word(rng)];
+                buffer += "?id=";
+                buffer += std::to_string(user_id(rng));
+            }
+
+            // иногда вставим пунктуацию, чтобы токенизация была не тривиальной
+            if (i + 1 < wc) {
+                if (maybe_comma(rng) < 12) buffer += ", ";
+                else buffer += " ";
+            }
+        }
+
+        // добавим user_id и "tag"
+        append_punct(rng, buffer);
+        buffer += "user_";
+        buffer += std::to_string(user_id(rng));
+        append_punct(rng, buffer);
+        buffer += "[tag_";
+        buffer += std::to_string(user_id(rng) % 1000);
+        buffer += "]\n";
+
+        // если буфер разросся — сбросим в файл; последний блок
+        // подрезаем точно до цели (чтобы размеры были ровнее)
+        if (buffer.size() >= flush_bytes || written + buffer.size() >= bytes_target) {
+            size_t n = (size_t)std::min<uint64_t>(buffer.size(), bytes_target - written);
+            ofs.write(buffer.data(), static_cast<std::streamsize>(n));
+            written += n;
+            buffer.clear();
+        }
+    }
+
+    ofs.close();
+    if (!ofs) {
+        std::cerr << "Failed to write: " << path.string() << "\n";
+        return false;
+    }
+    return true;
 }
 
 int main(int argc, char** argv) {
@@ -172,7 +343,6 @@ int main(int argc, char** argv) {
     }
 
     // 2) Распределение частот: вес ~ 1/(rank^skew)
-    //    discrete_distribution принимает веса double.
     std::vector<double> weights;
     weights.reserve((size_t)a.vocab);
     for (int i = 0; i < a.vocab; i++) {
@@ -180,140 +350,48 @@ int main(int argc, char** argv) {
         double w = 1.0 / std::pow(rank, std::max(0.0, a.skew));
         weights.push_back(w);
     }
-    std::discrete_distribution<int> pick_word(weights.begin(), weights.end());
-
-    // 3) Параметры "лог-строки"
-    std::uniform_int_distribution<int> msg_words(6, 18);     // слов в сообщении
-    std::uniform_int_distribution<int> maybe_comma(0, 99);   // иногда вставлять пунктуацию
-    std::uniform_int_distribution<int> maybe_path(0, 99);    // иногда вставлять path-like токен
-    std::uniform_int_distribution<int> code_dist(100, 599);  // http-like codes
-    std::uniform_int_distribution<int> user_id(1, 2000000);
-
-    auto make_path_token = [&](std::mt19937_64& r) -> std::string {
-        // /api/v1/<word>/<word>?id=123
-        std::ostringstream oss;
-        oss << "/api/v1/";
-        oss << vocab[(size_t)pick_word(r)] << "/";
-        oss << vocab[(size_t)pick_word(r)] << "?id=" << user_id(r);
-        return oss.str();
-    };
+    const Corpus corpus{std::move(vocab), AliasTable(weights)};
 
     const uint64_t bytes_target_per_file = uint64_t(a.mib_per_file) * 1024ull * 1024ull;
 
+    int threads = a.threads;
+    if (threads == 0) threads = std::max(1, (int)std::thread::hardware_concurrency());
+    threads = std::min(threads, a.files);
+
     std::cout << "Generating into: " << out.string() << "\n"
               << "Seed: " << seed << "\n"
               << "Files: " << a.files << ", ~" << a.mib_per_file << " MiB each\n"
-              << "Vocab: " << a.vocab << ", Skew: " << a.skew << "\n";
-
-    // 4) Генерим файлы
-    for (int fi = 0; fi < a.files; fi++) {
-        std::ostringstream fname;
-        fname << "log_" << std::setw(4) << std::setfill('0') << fi << ".txt";
-        fs::path path = out / fname.str();
-
-        std::ofstream ofs(path, std::ios::binary);
-        if (!ofs) {
-            std::cerr << "Failed to open: " << path.string() << "\n";
-            return 1;
-        }
-
-        // Крупный буфер для ускорения записи
-        std::string buffer;
-        buffer.reserve(1 << 20); // ~1MB
-
-        uint64_t written = 0;
-        uint64_t base_ts = 1700000000ull + uint64_t(fi) * 12345ull; // псевдо-epoch
-
-        while (written < bytes_target_per_file) {
-            // Таймстемп + уровень + ip + код
-            uint64_t ts = base_ts + (written / 200); // слегка растёт
-            buffer += std::to_string(ts);
-            buffer += rand_punct(rng);
-            buffer += rand_level(rng);
-            buffer += rand_punct(rng);
-            buffer += "ip=" + rand_ip(rng);
-            buffer += rand_punct(rng);
-            buffer += "code=" + std::to_string(code_dist(rng));
-            buffer += rand_punct(rng);
-
-            int wc = msg_words(rng);
-            for (int i = 0; i < wc; i++) {
-                int idx = pick_word(rng);
-                std::string w = maybe_mutate(rng, vocab[(size_t)idx]);
-                buffer += w;
-
-                if (maybe_path(rng) < 6) {
-                    buffer += rand_punct(rng);
-                    buffer += make_path_token(rng);
-                }
-
-                // иногда вставим пунктуацию, чтобы токенизация была не тривиальной
-                if (i + 1 < wc) {
-                    if (maybe_comma(rng) < 12) buffer += ", ";
-                    else buffer += " ";
-                }
+              << "Vocab: " << a.vocab << ", Skew: " << a.skew << "\n"
+              << "Threads: " << threads << "\n";
+
+    // 3) Генерим файлы: потоки разбирают номера файлов по одному
+    std::atomic<int> next_file{0};
+    std::atomic<bool> failed{false};
+    std::mutex print_mutex;
+
+    auto work = [&] {
+        for (int fi = next_file++; fi < a.files && !failed; fi = next_file++) {
+            std::ostringstream fname;
+            fname << "log_" << std::setw(4) << std::setfill('0') << fi << ".txt";
+            fs::path path = out / fname.str();
+
+            if (!generate_file(corpus, path, fi, seed, bytes_target_per_file)) {
+                failed = true;
+                return;
             }
 
-            // добавим user_id и "tag"
-            buffer += rand_punct(rng);
-            buffer += "user_" + std::to_string(user_id(rng));
-            buffer += rand_punct(rng);
-            buffer += "[tag_" + std::to_string(user_id(rng) % 1000) + "]";
-            buffer += "\n";
-
-            // если буфер разросся — сбросим в файл
-            if (buffer.size() >= (1 << 20)) {
-                ofs.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
-                written += buffer.size();
-                buffer.clear();
-            }
-        }
-
-        // Допишем остаток
-        if (!buffer.empty()) {
-            ofs.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
-            written += buffer.size();
-            buffer.clear();
-        }
-
-        ofs.close();
-
-        // подрежем файл точно до цели (чтобы размеры были ровнее)
-        // (не обязательно, но удобно)
-        try {
-            auto sz = fs::file_size(path);
-            if (sz > bytes_target_per_file) {
-                // Быстро "обрежем": перепишем в новый файл нужное количество
-                fs::path tmp = path;
-                tmp += ".tmp";
-
-                std::ifstream ifs(path, std::ios::binary);
-                std::ofstream tfs(tmp, std::ios::binary);
-
-                std::vector<char> chunk(1 << 20);
-                uint64_t remain = bytes_target_per_file;
-                while (remain > 0 && ifs) {
-                    auto to_read = (size_t)std::min<uint64_t>(chunk.size(), remain);
-                    ifs.read(chunk.data(), (std::streamsize)to_read);
-                    auto got = (size_t)ifs.gcount();
-                    if (got == 0) break;
-                    tfs.write(chunk.data(), (std::streamsize)got);
-                    remain -= got;
-                }
-                ifs.close();
-                tfs.close();
-
-                fs::remove(path);
-                fs::rename(tmp, path);
-            }
-        } catch (...) {
-            // если не получилось — не критично
+            std::lock_guard<std::mutex> lock(print_mutex);
+            std::cout << "  wrote " << path.filename().string()
+                      << " (" << (bytes_target_per_file / 1024) << " KiB)\n";
         }
+    };
 
-        std::cout << "  wrote " << path.filename().string()
-                  << " (" << (fs::file_size(path) / 1024) << " KiB)\n";
-    }
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(work);
+    work();
+    for (auto& th : pool) th.join();
 
+    if (failed) return 1;
     std::cout << "Done.\n";
     return 0;
 }
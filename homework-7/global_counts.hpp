@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "word_table.hpp"
+
+enum class MergeStrategy {
+    Single,
+    Sharded,
+};
+
+inline MergeStrategy parse_merge_strategy(const std::string& name) {
+    if (name == "single") {
+        return MergeStrategy::Single;
+    }
+    if (name == "sharded") {
+        return MergeStrategy::Sharded;
+    }
+    throw std::runtime_error("Unknown --merge strategy: " + name + " (expected single|sharded)");
+}
+
+inline const char* merge_strategy_name(MergeStrategy strategy) {
+    return strategy == MergeStrategy::Sharded ? "sharded" : "single";
+}
+
+struct ShardStats {
+    std::uint64_t acquisitions = 0;
+    std::uint64_t contended = 0;
+    std::size_t words = 0;
+};
+
+// Глобальный частотный словарь, разбитый на сегменты по хешу слова.
+// У каждого сегмента свой mutex, поэтому потоки, сливающие локальные
+// таблицы одновременно, в основном не мешают друг другу. Стратегия
+// Single — исходная схема с одной таблицей под одним mutex.
+//
+// Строки при слиянии не копируются: сегменты ссылаются на байты в арене
+// локальной таблицы, а сама арена переезжает в GlobalCounts. Цена —
+// слова, уже известные глобально, остаются в арене мёртвым грузом.
+class GlobalCounts {
+public:
+    GlobalCounts(MergeStrategy strategy, std::size_t shard_count)
+        : shards_(strategy == MergeStrategy::Sharded ? shard_count : 1) {
+        if (shards_.empty()) {
+            throw std::runtime_error("Shard count must be >= 1");
+        }
+    }
+
+    GlobalCounts(const GlobalCounts&) = delete;
+    GlobalCounts& operator=(const GlobalCounts&) = delete;
+
+    // Сливает и опустошает local. worker задаёт сегмент, с которого поток
+    // начинает обход, чтобы разные потоки не выстраивались в очередь к
+    // одному и тому же mutex. copy_words копирует в сегменты только новые
+    // слова, а арена local освобождается: дольше, зато повторные сбросы не
+    // копят мёртвые строки (нужно при --mem-limit).
+    void merge(WordTable& local, std::size_t worker = 0, bool copy_words = false) {
+        if (local.empty()) {
+            return;
+        }
+
+        auto insert = [copy_words](WordTable& counts, std::string_view word, std::uint32_t hash,
+                                   std::uint64_t count) {
+            if (copy_words) {
+                counts.add(word, hash, count);
+            } else {
+                counts.add_interned(word, hash, count);
+            }
+        };
+
+        if (shards_.size() == 1) {
+            Shard& shard = shards_.front();
+            lock(shard);
+            std::lock_guard<std::mutex> guard(shard.mutex, std::adopt_lock);
+            const std::size_t before = shard.counts.memory_bytes();
+            shard.counts.reserve(local.size());
+            local.for_each_hashed([&shard, &insert](std::string_view word, std::uint32_t hash, std::uint64_t count) {
+                insert(shard.counts, word, hash, count);
+            });
+            memory_ += shard.counts.memory_bytes() - before;
+        } else {
+            struct Entry {
+                std::string_view word;
+                std::uint32_t hash;
+                std::uint64_t count;
+            };
+            std::vector<std::vector<Entry>> buckets(shards_.size());
+            local.for_each_hashed([this, &buckets](std::string_view word, std::uint32_t hash, std::uint64_t count) {
+                buckets[hash % shards_.size()].push_back(Entry{word, hash, count});
+            });
+
+            for (std::size_t step = 0; step < shards_.size(); ++step) {
+                const std::size_t index = (worker + step) % shards_.size();
+                if (buckets[index].empty()) {
+                    continue;
+                }
+
+                Shard& shard = shards_[index];
+                lock(shard);
+                std::lock_guard<std::mutex> guard(shard.mutex, std::adopt_lock);
+                const std::size_t before = shard.counts.memory_bytes();
+                shard.counts.reserve(buckets[index].size());
+                for (const Entry& entry : buckets[index]) {
+                    insert(shard.counts, entry.word, entry.hash, entry.count);
+                }
+                memory_ += shard.counts.memory_bytes() - before;
+            }
+        }
+
+        StringArena arena = local.release_arena();
+        if (copy_words) {
+            return;
+        }
+        memory_ += arena.reserved_bytes();
+        std::lock_guard<std::mutex> guard(arena_mutex_);
+        arena_.absorb(std::move(arena));
+    }
+
+    // Оценка памяти сегментов и арены; можно читать во время слияний.
+    std::size_t memory_bytes() const noexcept {
+        return memory_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t shard_count() const noexcept {
+        return shards_.size();
+    }
+
+    // Доступ к содержимому — только после завершения всех потоков.
+    const WordTable& shard(std::size_t index) const {
+        return shards_[index].counts;
+    }
+
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (const auto& shard : shards_) {
+            total += shard.counts.size();
+        }
+        return total;
+    }
+
+    std::vector<ShardStats> stats() const {
+        std::vector<ShardStats> result;
+        result.reserve(shards_.size());
+        for (const auto& shard : shards_) {
+            result.push_back(ShardStats{shard.acquisitions, shard.contended, shard.counts.size()});
+        }
+        return result;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        WordTable counts;
+        std::uint64_t acquisitions = 0;  // оба счётчика меняются под mutex
+        std::uint64_t contended = 0;
+    };
+
+    static void lock(Shard& shard) {
+        const bool contended = !shard.mutex.try_lock();
+        if (contended) {
+            shard.mutex.lock();
+        }
+        ++shard.acquisitions;
+        if (contended) {
+            ++shard.contended;
+        }
+    }
+
+    std::vector<Shard> shards_;
+    std::mutex arena_mutex_;
+    StringArena arena_;
+    std::atomic<std::size_t> memory_{0};
+};
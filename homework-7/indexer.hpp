@@ -0,0 +1,287 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cancellation.hpp"
+#include "directory_walker.hpp"
+#include "file_processor.hpp"
+#include "global_counts.hpp"
+#include "progress.hpp"
+#include "task_queue.hpp"
+#include "work_stealing.hpp"
+
+// Когда worker сливает локальную мапу в глобальную. Нули означают
+// «только при завершении потока».
+struct FlushPolicy {
+    std::size_t every_tasks = 0;
+    std::uint64_t every_bytes = 0;
+};
+
+struct IndexerOptions {
+    std::size_t threads = 1;
+    std::size_t minlen = 3;
+    Encoding encoding = Encoding::Ascii;
+    IoMode io = IoMode::Stream;
+    std::uint64_t chunk_bytes = 64ull * 1024 * 1024;
+    FlushPolicy flush;
+    Scheduler scheduler = Scheduler::Queue;
+    bool recursive = false;
+    std::size_t walkers = 1;  // потоков обхода каталогов
+    TaskOrder order = TaskOrder::Discovery;
+    std::chrono::milliseconds progress{0};  // период отчёта в stderr, 0 — без отчёта
+    std::uint64_t mem_limit = 0;            // байт на все таблицы, 0 — без ограничения
+};
+
+// Бюджет локальной таблицы одного worker'а при --mem-limit: половина лимита
+// делится между потоками, вторая половина остаётся глобальной таблице.
+inline std::uint64_t local_memory_budget(const IndexerOptions& options) {
+    return options.mem_limit / (2 * options.threads);
+}
+
+// Загрузка одного worker'а: busy — обработка задач и слияние, idle —
+// ожидание задачи в очереди.
+struct WorkerStats {
+    std::size_t tasks = 0;
+    std::uint64_t bytes = 0;
+    std::chrono::nanoseconds busy{0};
+    std::chrono::nanoseconds idle{0};
+    std::size_t spills = 0;  // сбросов из-за --mem-limit
+};
+
+// Файл, не посчитанный целиком из-за отмены.
+struct SkippedFile {
+    std::filesystem::path path;
+    std::uint64_t skipped_bytes = 0;
+    std::uint64_t size = 0;
+};
+
+struct IndexerStats {
+    std::vector<WorkerStats> workers;
+    std::uint64_t steals = 0;
+    std::size_t files = 0;  // найдено при обходе
+    bool cancelled = false;
+    std::vector<SkippedFile> skipped;  // по пути; только при отмене
+};
+
+namespace detail {
+
+// Сводит задачи, не попавшие к workers, в список файлов.
+inline std::vector<SkippedFile> summarize_skipped(std::vector<Task> tasks) {
+    std::sort(tasks.begin(), tasks.end(), [](const Task& lhs, const Task& rhs) {
+        return lhs.path < rhs.path;
+    });
+    std::vector<SkippedFile> files;
+    for (const Task& task : tasks) {
+        if (files.empty() || files.back().path != task.path) {
+            std::error_code ec;
+            const std::uint64_t size = std::filesystem::file_size(task.path, ec);
+            files.push_back(SkippedFile{task.path, 0, ec ? 0 : size});
+        }
+        files.back().skipped_bytes += task.length;
+    }
+    return files;
+}
+
+}  // namespace detail
+
+// Producer обходит каталог (options.walkers потоками) и режет файлы на
+// задачи, workers считают слова в локальные мапы и сливают их в global
+// согласно FlushPolicy. Задачи раздаёт TaskQueue или WorkStealingQueue —
+// по options.scheduler.
+//
+// При TaskOrder::LargestFirst задачи копятся до конца обхода и уходят по
+// убыванию длины: большие файлы начинаются первыми и не остаются хвостом
+// в конце прогона. Обход при этом — только stat без чтения, так что
+// ожидание workers мало по сравнению с самим подсчётом.
+//
+// После cancel->request() очередь закрывается, невзятые задачи и файлы,
+// найденные позже, уходят в stats.skipped; workers доделывают текущую
+// задачу и, как обычно, сливают локальные таблицы. Задача кончается на
+// разделителе, так что global точно соответствует всем посчитанным
+// задачам, а лишняя задержка — не больше одного чанка.
+inline IndexerStats run_indexer(const IndexerOptions& options,
+                                const std::filesystem::path& input_dir,
+                                GlobalCounts& global,
+                                Cancellation* cancel = nullptr) {
+    using Clock = std::chrono::steady_clock;
+
+    const bool steal = options.scheduler == Scheduler::Steal;
+    TaskQueue queue;
+    WorkStealingQueue steal_queue(options.threads);
+    IndexerProgress progress(options.threads);
+
+    std::mutex skipped_mutex;
+    std::vector<Task> skipped;
+    auto skip = [&](std::vector<Task> tasks) {
+        std::lock_guard<std::mutex> lock(skipped_mutex);
+        std::move(tasks.begin(), tasks.end(), std::back_inserter(skipped));
+    };
+    const Cancellation::Subscription on_cancel(cancel, [&] {
+        skip(steal ? steal_queue.cancel() : queue.cancel());
+    });
+
+    auto push = [&](Task task) {
+        progress.add_found(task.length);
+        Task copy = task;
+        const bool accepted = steal ? steal_queue.push(std::move(task)) : queue.push(std::move(task));
+        if (!accepted) {
+            skip({std::move(copy)});
+        }
+    };
+    auto pop = [&](std::size_t worker, Task& task) {
+        return steal ? steal_queue.pop(worker, task) : queue.pop(task);
+    };
+
+    // Таблица растёт внутри задачи, а проверяется между задачами, поэтому
+    // при --mem-limit задачи мельче бюджета.
+    const std::uint64_t memory_budget = local_memory_budget(options);
+    std::uint64_t chunk_bytes = options.chunk_bytes;
+    if (memory_budget != 0) {
+        const std::uint64_t cap = std::max<std::uint64_t>(1024 * 1024, memory_budget / 4);
+        chunk_bytes = chunk_bytes == 0 ? cap : std::min(chunk_bytes, cap);
+    }
+
+    // После отмены файлы только перечисляются, без чтения.
+    std::atomic<std::size_t> files_found{0};
+    auto split = [&](const std::filesystem::path& path, std::uint64_t size, auto&& emit) {
+        files_found.fetch_add(1, std::memory_order_relaxed);
+        if (cancel != nullptr && cancel->requested()) {
+            skip({Task{path, 0, size}});
+            return;
+        }
+        progress.add_found_file();
+        auto file_left = std::make_shared<std::atomic<std::uint64_t>>(size);
+        split_file(path, size, chunk_bytes, [&emit, &file_left](Task task) {
+            task.file_left = file_left;
+            emit(std::move(task));
+        });
+    };
+
+    ProgressReporter reporter(progress, global, options.progress);
+    std::thread producer([&] {
+        const WalkOptions walk{options.recursive, options.walkers};
+        if (options.order == TaskOrder::Discovery) {
+            walk_directory(input_dir, walk, [&](const std::filesystem::path& path, std::uint64_t size) {
+                split(path, size, push);
+            });
+        } else {
+            std::mutex found_mutex;
+            std::vector<Task> found;
+            walk_directory(input_dir, walk, [&](const std::filesystem::path& path, std::uint64_t size) {
+                std::vector<Task> chunks;
+                split(path, size, [&chunks](Task task) {
+                    chunks.push_back(std::move(task));
+                });
+                std::lock_guard<std::mutex> lock(found_mutex);
+                std::move(chunks.begin(), chunks.end(), std::back_inserter(found));
+            });
+            std::stable_sort(found.begin(), found.end(), [](const Task& lhs, const Task& rhs) {
+                return lhs.length > rhs.length;
+            });
+            for (Task& task : found) {
+                push(std::move(task));
+            }
+        }
+        progress.finish_walk();
+        if (steal) {
+            steal_queue.close();
+        } else {
+            queue.close();
+        }
+    });
+
+    IndexerStats stats;
+    stats.workers.resize(options.threads);
+
+    std::vector<std::thread> workers;
+    workers.reserve(options.threads);
+
+    for (std::size_t i = 0; i < options.threads; ++i) {
+        workers.emplace_back([&pop, &global, &options, &stats, &progress, memory_budget, i] {
+            const FlushPolicy& flush = options.flush;
+            WorkerStats& worker_stats = stats.workers[i];
+            WorkerProgress& live = progress.worker(i);
+            WordTable local_counts;
+            std::size_t pending_tasks = 0;
+            std::uint64_t pending_bytes = 0;
+
+            Task task;
+            auto waited_from = Clock::now();
+            while (pop(i, task)) {
+                const auto started = Clock::now();
+                worker_stats.idle += started - waited_from;
+
+                const std::uint64_t tokens_before = local_counts.total();
+                const std::uint64_t bytes = process_file(task, options.io, options.minlen, options.encoding, local_counts);
+                pending_bytes += bytes;
+                ++pending_tasks;
+                worker_stats.bytes += bytes;
+                ++worker_stats.tasks;
+                live.bytes.fetch_add(task.length, std::memory_order_relaxed);
+                live.tasks.fetch_add(1, std::memory_order_relaxed);
+                if (task.file_left != nullptr &&
+                    task.file_left->fetch_sub(task.length, std::memory_order_relaxed) == task.length) {
+                    live.files.fetch_add(1, std::memory_order_relaxed);
+                }
+                live.tokens.fetch_add(local_counts.total() - tokens_before, std::memory_order_relaxed);
+
+                if (memory_budget != 0 && local_counts.memory_bytes() > memory_budget) {
+                    // Слова копируются, а таблица пересоздаётся: память
+                    // локальной таблицы действительно освобождается.
+                    global.merge(local_counts, i, true);
+                    local_counts = WordTable();
+                    pending_tasks = 0;
+                    pending_bytes = 0;
+                    ++worker_stats.spills;
+                } else if ((flush.every_tasks != 0 && pending_tasks >= flush.every_tasks) ||
+                           (flush.every_bytes != 0 && pending_bytes >= flush.every_bytes)) {
+                    global.merge(local_counts, i, memory_budget != 0);
+                    pending_tasks = 0;
+                    pending_bytes = 0;
+                }
+                live.words.store(local_counts.size(), std::memory_order_relaxed);
+                live.memory.store(local_counts.memory_bytes(), std::memory_order_relaxed);
+
+                waited_from = Clock::now();
+                worker_stats.busy += waited_from - started;
+            }
+            const auto finished = Clock::now();
+            worker_stats.idle += finished - waited_from;
+            global.merge(local_counts, i, memory_budget != 0);
+            live.words.store(0, std::memory_order_relaxed);
+            live.memory.store(0, std::memory_order_relaxed);
+            worker_stats.busy += Clock::now() - finished;
+        });
+    }
+
+    producer.join();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    reporter.stop();
+    stats.steals = steal_queue.steals();
+    stats.files = files_found.load();
+    stats.cancelled = cancel != nullptr && cancel->requested();
+    if (stats.cancelled) {
+        std::lock_guard<std::mutex> lock(skipped_mutex);
+        stats.skipped = detail::summarize_skipped(std::move(skipped));
+    }
+    if (options.mem_limit != 0 && global.memory_bytes() > options.mem_limit) {
+        std::cerr << "Warning: the word table alone needs ~" << global.memory_bytes() / (1024 * 1024)
+                  << " MiB, more than --mem-limit\n";
+    }
+    return stats;
+}
@@ -1,114 +1,116 @@
-#include <algorithm>
-#include <cctype>
-#include <condition_variable>
+#include <chrono>
 #include <cstdint>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
-#include <mutex>
-#include <queue>
 #include <stdexcept>
 #include <string>
-#include <thread>
-#include <unordered_map>
-#include <utility>
 #include <vector>
 
+#include "cancellation.hpp"
+#include "global_counts.hpp"
+#include "indexer.hpp"
+#include "persistent_index.hpp"
+#include "top_words.hpp"
+
 namespace fs = std::filesystem;
 
 namespace {
 
 struct Config {
-    std::size_t threads = 1;
+    IndexerOptions indexer;
     std::size_t top = 20;
-    std::size_t minlen = 3;
+    MergeStrategy merge = MergeStrategy::Single;
+    std::size_t shards = 16;
+    bool stats = false;
+    fs::path index_file;
     fs::path input_dir;
 };
 
-class TaskQueue {
-public:
-    void push(fs::path path) {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            queue_.push(std::move(path));
-        }
-        cv_.notify_one();
+void print_top(const std::vector<WordEntry>& top) {
+    for (const auto& entry : top) {
+        std::cout << entry.word << ' ' << entry.count << '\n';
     }
+}
 
-    bool pop(fs::path& out) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        cv_.wait(lock, [this] { return closed_ || !queue_.empty(); });
-        if (queue_.empty()) {
-            return false;
-        }
-        out = std::move(queue_.front());
-        queue_.pop();
-        return true;
+// Запрос к готовому индексу без чтения логов.
+int query_index(const Config& cfg) {
+    const IndexView index(cfg.index_file);
+    if (!index.exists()) {
+        std::cerr << "Index file does not exist: " << cfg.index_file << '\n';
+        return 1;
     }
-
-    void close() {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            closed_ = true;
-        }
-        cv_.notify_all();
+    if (cfg.indexer.minlen < index.minlen()) {
+        std::cerr << "Index was built with --minlen " << index.minlen() << '\n';
+        return 1;
     }
-
-private:
-    std::queue<fs::path> queue_;
-    bool closed_{false};
-    std::mutex mutex_;
-    std::condition_variable cv_;
-};
-
-bool is_word_char(unsigned char c) {
-    return std::isalnum(c) != 0 || c == '_';
-}
-
-void flush_word(std::string& token, std::size_t minlen, std::unordered_map<std::string, std::uint64_t>& local_counts) {
-    if (token.size() >= minlen) {
-        ++local_counts[token];
+    if (cfg.indexer.encoding != index.encoding()) {
+        std::cerr << "Index was built in " << encoding_name(index.encoding()) << " mode\n";
+        return 1;
     }
-    token.clear();
+    print_top(index.top(cfg.top, cfg.indexer.minlen));
+    return 0;
 }
 
-void process_line(const std::string& line, std::size_t minlen, std::unordered_map<std::string, std::uint64_t>& local_counts) {
-    std::string token;
-    token.reserve(64);
-
-    for (unsigned char c : line) {
-        if (is_word_char(c)) {
-            token.push_back(static_cast<char>(std::tolower(c)));
-        } else if (!token.empty()) {
-            flush_word(token, minlen, local_counts);
-        }
-    }
-
-    if (!token.empty()) {
-        flush_word(token, minlen, local_counts);
+// Обновляет индекс по каталогу и отвечает по свежим частотам.
+int run_with_index(const Config& cfg) {
+    IndexUpdateStats stats;
+    const std::vector<IndexedFile> files = update_index(
+        cfg.indexer, cfg.input_dir, load_index(cfg.index_file, cfg.indexer.minlen, cfg.indexer.encoding), stats);
+    std::cerr << "index: " << stats.unchanged << " unchanged, " << stats.appended << " appended, "
+              << stats.rescanned << " rescanned, " << stats.removed << " removed\n";
+
+    // Слова не копируются: totals ссылается на арены таблиц files.
+    WordTable totals;
+    for (const IndexedFile& file : files) {
+        totals.reserve(file.counts.size());
+        file.counts.for_each_hashed([&totals](std::string_view word, std::uint32_t hash, std::uint64_t count) {
+            totals.add_interned(word, hash, count);
+        });
     }
+    save_index(cfg.index_file, cfg.indexer.minlen, cfg.indexer.encoding, files, totals);
+    print_top(select_top(totals, cfg.top));
+    return 0;
 }
 
-void process_file(const fs::path& file_path,
-                  std::size_t minlen,
-                  std::unordered_map<std::string, std::uint64_t>& local_counts) {
-    std::ifstream file(file_path);
-    if (!file) {
-        return;
+void print_shard_stats(const GlobalCounts& global) {
+    const auto stats = global.stats();
+    std::cerr << "shard acquisitions contended words\n";
+    for (std::size_t i = 0; i < stats.size(); ++i) {
+        std::cerr << i << ' ' << stats[i].acquisitions << ' '
+                  << stats[i].contended << ' ' << stats[i].words << '\n';
     }
+}
 
-    std::string line;
-    while (std::getline(file, line)) {
-        process_line(line, minlen, local_counts);
+void print_worker_stats(const IndexerStats& stats) {
+    using Ms = std::chrono::duration<double, std::milli>;
+    std::cerr << "worker tasks MiB busy_ms idle_ms spills\n";
+    for (std::size_t i = 0; i < stats.workers.size(); ++i) {
+        const WorkerStats& worker = stats.workers[i];
+        std::cerr << i << ' ' << worker.tasks << ' ' << worker.bytes / (1024 * 1024) << ' '
+                  << Ms(worker.busy).count() << ' ' << Ms(worker.idle).count() << ' '
+                  << worker.spills << '\n';
     }
+    std::cerr << "steals " << stats.steals << '\n';
 }
 
-void merge_local(std::unordered_map<std::string, std::uint64_t>& global_counts,
-                 std::mutex& global_mutex,
-                 std::unordered_map<std::string, std::uint64_t>& local_counts) {
-    std::lock_guard<std::mutex> lock(global_mutex);
-    for (auto& [word, count] : local_counts) {
-        global_counts[word] += count;
+// После Ctrl+C: какие файлы не вошли в результат целиком.
+void print_cancel_summary(const IndexerStats& stats) {
+    std::size_t partial = 0;
+    for (const auto& file : stats.skipped) {
+        if (file.skipped_bytes < file.size) {
+            ++partial;
+        }
+    }
+    std::cerr << "Interrupted: top covers " << stats.files - stats.skipped.size() << " of " << stats.files
+              << " files completely, " << partial << " partially, "
+              << stats.skipped.size() - partial << " skipped\n";
+    for (const auto& file : stats.skipped) {
+        if (file.skipped_bytes < file.size) {
+            std::cerr << "partial " << file.path.string() << " (" << file.size - file.skipped_bytes
+                      << " of " << file.size << " bytes counted)\n";
+        } else {
+            std::cerr << "skipped " << file.path.string() << '\n';
+        }
     }
 }
 
@@ -122,7 +124,7 @@ Config parse_args(int argc, char* argv[]) {
             if (i + 1 >= argc) {
                 throw std::runtime_error("Missing value for --threads");
             }
-            cfg.threads = static_cast<std::size_t>(std::stoul(argv[++i]));
+            cfg.indexer.threads = static_cast<std::size_t>(std::stoul(argv[++i]));
             continue;
         }
         if (arg == "--top") {
@@ -136,21 +138,128 @@ Config parse_args(int argc, char* argv[]) {
             if (i + 1 >= argc) {
                 throw std::runtime_error("Missing value for --minlen");
             }
-            cfg.minlen = static_cast<std::size_t>(std::stoul(argv[++i]));
+            cfg.indexer.minlen = static_cast<std::size_t>(std::stoul(argv[++i]));
+            continue;
+        }
+        if (arg == "--utf8") {
+            cfg.indexer.encoding = Encoding::Utf8;
+            continue;
+        }
+        if (arg == "--io") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --io");
+            }
+            cfg.indexer.io = parse_io_mode(argv[++i]);
+            continue;
+        }
+        if (arg == "--chunk-mib") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --chunk-mib");
+            }
+            cfg.indexer.chunk_bytes = std::stoull(argv[++i]) * 1024 * 1024;
+            continue;
+        }
+        if (arg == "--merge") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --merge");
+            }
+            cfg.merge = parse_merge_strategy(argv[++i]);
+            continue;
+        }
+        if (arg == "--shards") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --shards");
+            }
+            cfg.shards = static_cast<std::size_t>(std::stoul(argv[++i]));
+            continue;
+        }
+        if (arg == "--flush-files") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --flush-files");
+            }
+            cfg.indexer.flush.every_tasks = static_cast<std::size_t>(std::stoul(argv[++i]));
+            continue;
+        }
+        if (arg == "--flush-mib") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --flush-mib");
+            }
+            cfg.indexer.flush.every_bytes = std::stoull(argv[++i]) * 1024 * 1024;
+            continue;
+        }
+        if (arg == "--progress") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --progress");
+            }
+            cfg.indexer.progress = std::chrono::milliseconds(
+                static_cast<std::int64_t>(std::stod(argv[++i]) * 1000));
+            continue;
+        }
+        if (arg == "--mem-limit") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --mem-limit");
+            }
+            cfg.indexer.mem_limit = std::stoull(argv[++i]) * 1024 * 1024;
+            continue;
+        }
+        if (arg == "--recursive") {
+            cfg.indexer.recursive = true;
+            continue;
+        }
+        if (arg == "--walkers") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --walkers");
+            }
+            cfg.indexer.walkers = static_cast<std::size_t>(std::stoul(argv[++i]));
+            continue;
+        }
+        if (arg == "--order") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --order");
+            }
+            cfg.indexer.order = parse_task_order(argv[++i]);
+            continue;
+        }
+        if (arg == "--scheduler") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --scheduler");
+            }
+            cfg.indexer.scheduler = parse_scheduler(argv[++i]);
+            continue;
+        }
+        if (arg == "--index-file") {
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for --index-file");
+            }
+            cfg.index_file = fs::path(argv[++i]);
+            continue;
+        }
+        if (arg == "--stats") {
+            cfg.stats = true;
             continue;
         }
 
         positional.push_back(arg);
     }
 
-    if (cfg.threads == 0 || cfg.top == 0 || cfg.minlen == 0) {
-        throw std::runtime_error("--threads, --top and --minlen must be >= 1");
+    if (cfg.indexer.threads == 0 || cfg.top == 0 || cfg.indexer.minlen == 0 || cfg.shards == 0 ||
+        cfg.indexer.walkers == 0) {
+        throw std::runtime_error("--threads, --top, --minlen, --shards and --walkers must be >= 1");
     }
-    if (positional.size() != 1) {
-        throw std::runtime_error("Usage: ./homework_7 --threads K --top M --minlen L <path>");
+    // С --index-file путь можно не указывать: тогда ответ берётся из индекса.
+    if (positional.size() > 1 || (positional.empty() && cfg.index_file.empty())) {
+        throw std::runtime_error(
+            "Usage: ./homework_7 --threads K --top M --minlen L [--utf8] [--io stream|mmap] [--chunk-mib C]\n"
+            "       [--merge single|sharded] [--shards N] [--flush-files K] [--flush-mib X]\n"
+            "       [--scheduler queue|steal] [--recursive] [--walkers W] [--order discovery|largest]\n"
+            "       [--progress SEC] [--mem-limit MIB] [--stats]\n"
+            "       [--index-file FILE] <path>\n"
+            "       ./homework_7 --index-file FILE [--top M] [--minlen L] [--utf8]");
     }
 
-    cfg.input_dir = fs::path(positional.front());
+    if (!positional.empty()) {
+        cfg.input_dir = fs::path(positional.front());
+    }
     return cfg;
 }
 
@@ -159,60 +268,35 @@ Config parse_args(int argc, char* argv[]) {
 int main(int argc, char* argv[]) {
     try {
         const Config cfg = parse_args(argc, argv);
+        if (cfg.input_dir.empty()) {
+            return query_index(cfg);
+        }
 
         if (!fs::exists(cfg.input_dir) || !fs::is_directory(cfg.input_dir)) {
             std::cerr << "Input path is not a directory: " << cfg.input_dir << '\n';
             return 1;
         }
 
-        TaskQueue queue;
-        std::unordered_map<std::string, std::uint64_t> global_counts;
-        std::mutex global_mutex;
-
-        std::thread producer([&queue, &cfg] {
-            for (const auto& entry : fs::directory_iterator(cfg.input_dir)) {
-                if (entry.is_regular_file()) {
-                    queue.push(entry.path());
-                }
-            }
-            queue.close();
-        });
-
-        std::vector<std::thread> workers;
-        workers.reserve(cfg.threads);
-
-        for (std::size_t i = 0; i < cfg.threads; ++i) {
-            workers.emplace_back([&queue, &global_counts, &global_mutex, &cfg] {
-                std::unordered_map<std::string, std::uint64_t> local_counts;
-                fs::path file_path;
-                while (queue.pop(file_path)) {
-                    process_file(file_path, cfg.minlen, local_counts);
-                }
-                merge_local(global_counts, global_mutex, local_counts);
-            });
+        if (!cfg.index_file.empty()) {
+            return run_with_index(cfg);
         }
 
-        producer.join();
-        for (auto& worker : workers) {
-            worker.join();
+        GlobalCounts global(cfg.merge, cfg.shards);
+        Cancellation cancel;
+        IndexerStats indexer_stats;
+        {
+            const SignalWatcher watcher(cancel);
+            indexer_stats = run_indexer(cfg.indexer, cfg.input_dir, global, &cancel);
         }
-
-        std::vector<std::pair<std::string, std::uint64_t>> entries;
-        entries.reserve(global_counts.size());
-        for (auto& [word, count] : global_counts) {
-            entries.emplace_back(word, count);
+        if (cfg.stats) {
+            print_worker_stats(indexer_stats);
+            print_shard_stats(global);
         }
 
-        std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
-            if (lhs.second != rhs.second) {
-                return lhs.second > rhs.second;
-            }
-            return lhs.first < rhs.first;
-        });
-
-        const std::size_t limit = std::min(cfg.top, entries.size());
-        for (std::size_t i = 0; i < limit; ++i) {
-            std::cout << entries[i].first << ' ' << entries[i].second << '\n';
+        print_top(select_top(global, cfg.top, cfg.indexer.threads));
+        if (indexer_stats.cancelled) {
+            print_cancel_summary(indexer_stats);
+            return 130;
         }
 
         return 0;
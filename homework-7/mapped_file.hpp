@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Файл, отображённый в память только для чтения (POSIX mmap).
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::filesystem::path& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            return;
+        }
+
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ > 0) {
+            void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                size_ = 0;
+            } else {
+                data_ = static_cast<const char*>(data);
+                ::madvise(data, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+        opened_ = size_ == 0 || data_ != nullptr;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          opened_(std::exchange(other.opened_, false)) {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            opened_ = std::exchange(other.opened_, false);
+        }
+        return *this;
+    }
+
+    ~MappedFile() {
+        unmap();
+    }
+
+    explicit operator bool() const noexcept {
+        return opened_;
+    }
+
+    std::string_view view() const noexcept {
+        return data_ != nullptr ? std::string_view(data_, size_) : std::string_view();
+    }
+
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+private:
+    void unmap() noexcept {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<char*>(data_), size_);
+            data_ = nullptr;
+        }
+    }
+
+    const char* data_{nullptr};
+    std::size_t size_{0};
+    bool opened_{false};
+};
@@ -0,0 +1,491 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "directory_walker.hpp"
+#include "file_processor.hpp"
+#include "indexer.hpp"
+#include "mapped_file.hpp"
+#include "task_queue.hpp"
+#include "tokenizer.hpp"
+#include "top_words.hpp"
+#include "word_table.hpp"
+
+// Состояние одного файла в постоянном индексе.
+struct IndexedFile {
+    std::string path;               // относительно индексируемого каталога
+    std::uint64_t size = 0;         // сколько байт файла учтено в counts
+    std::int64_t mtime = 0;
+    std::uint64_t tail_offset = 0;  // позиция сразу после последнего разделителя
+    std::uint64_t prefix_hash = 0;  // хеш до 4 KiB перед tail_offset
+    WordTable counts;
+};
+
+struct IndexUpdateStats {
+    std::size_t unchanged = 0;
+    std::size_t appended = 0;
+    std::size_t rescanned = 0;
+    std::size_t removed = 0;
+};
+
+namespace detail {
+
+// Формат файла индекса (числа в нативном порядке байт, секции выровнены
+// на 8 байт):
+//   IndexHeader
+//   word_offsets: (word_count + 1) x u64 — границы слов в strings
+//   ranking:      word_count x RankEntry — все слова в порядке вывода
+//   files:        file_count x FileRecord
+//   file_counts:  FileCount — частоты по файлам, диапазоны в FileRecord
+//   strings:      байты слов, затем путей
+// ranking позволяет отвечать на --top чтением первых M записей.
+constexpr std::array<char, 8> kIndexMagic = {'H', 'W', '7', 'I', 'N', 'D', 'E', 'X'};
+constexpr std::uint32_t kIndexVersion = 2;
+constexpr std::uint64_t kPrefixHashBytes = 4096;
+
+struct IndexHeader {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t minlen;
+    std::uint32_t encoding;  // Encoding, с которым разобраны слова
+    std::uint32_t reserved;
+    std::uint64_t word_count;
+    std::uint64_t file_count;
+    std::uint64_t word_offsets;
+    std::uint64_t ranking;
+    std::uint64_t files;
+    std::uint64_t file_counts;
+    std::uint64_t strings;
+    std::uint64_t strings_size;
+};
+
+struct RankEntry {
+    std::uint64_t count;
+    std::uint32_t word;
+    std::uint32_t reserved;
+};
+
+struct FileRecord {
+    std::uint64_t size;
+    std::int64_t mtime;
+    std::uint64_t tail_offset;
+    std::uint64_t prefix_hash;
+    std::uint64_t path_offset;
+    std::uint64_t path_size;
+    std::uint64_t counts_begin;
+    std::uint64_t counts_size;
+};
+
+struct FileCount {
+    std::uint64_t count;
+    std::uint32_t word;
+    std::uint32_t reserved;
+};
+
+template <typename T>
+void append_pod(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// FNV-1a по байтам [begin, end) файла.
+inline std::uint64_t hash_file_region(const std::filesystem::path& path,
+                                      std::uint64_t begin,
+                                      std::uint64_t end) {
+    std::uint64_t hash = 14695981039346656037ull;
+    if (begin >= end) {
+        return hash;
+    }
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(static_cast<std::streamoff>(begin));
+    std::string buffer(static_cast<std::size_t>(end - begin), '\0');
+    file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.resize(static_cast<std::size_t>(file.gcount()));
+    for (unsigned char c : buffer) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+inline std::uint64_t prefix_hash(const std::filesystem::path& path, std::uint64_t tail_offset) {
+    const std::uint64_t begin = tail_offset > kPrefixHashBytes ? tail_offset - kPrefixHashBytes : 0;
+    return hash_file_region(path, begin, tail_offset);
+}
+
+// Позиция сразу после последнего разделителя в первых size байтах файла.
+// Всё, что дальше, — незаконченное слово, которое может продолжиться
+// при дописывании файла.
+inline std::uint64_t find_tail_offset(const std::filesystem::path& path, std::uint64_t size) {
+    std::ifstream file(path, std::ios::binary);
+    std::array<char, 4096> buffer{};
+    std::uint64_t end = size;
+    while (file && end > 0) {
+        const std::uint64_t begin = end > buffer.size() ? end - buffer.size() : 0;
+        file.seekg(static_cast<std::streamoff>(begin));
+        file.read(buffer.data(), static_cast<std::streamsize>(end - begin));
+        for (std::uint64_t i = static_cast<std::uint64_t>(file.gcount()); i > 0; --i) {
+            if (is_separator_byte(static_cast<unsigned char>(buffer[i - 1]))) {
+                return begin + i;
+            }
+        }
+        end = begin;
+    }
+    return 0;
+}
+
+inline std::int64_t file_mtime(const std::filesystem::path& path) {
+    return static_cast<std::int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+}
+
+}  // namespace detail
+
+// Индекс, отображённый в память. Все чтения проверяют границы файла.
+class IndexView {
+public:
+    explicit IndexView(const std::filesystem::path& path) {
+        if (!std::filesystem::exists(path)) {
+            return;
+        }
+        file_ = MappedFile(path);
+        if (!file_) {
+            throw std::runtime_error("Failed to open index file: " + path.string());
+        }
+        header_ = read<detail::IndexHeader>(0);
+        if (header_.magic != detail::kIndexMagic || header_.version != detail::kIndexVersion) {
+            throw std::runtime_error("Not a homework_7 index file: " + path.string());
+        }
+        exists_ = true;
+    }
+
+    bool exists() const noexcept {
+        return exists_;
+    }
+
+    std::size_t minlen() const noexcept {
+        return header_.minlen;
+    }
+
+    Encoding encoding() const noexcept {
+        return header_.encoding == static_cast<std::uint32_t>(Encoding::Utf8) ? Encoding::Utf8 : Encoding::Ascii;
+    }
+
+    // Лучшие limit слов длиной не меньше minlen — без пересчёта по логам.
+    std::vector<WordEntry> top(std::size_t limit, std::size_t minlen) const {
+        std::vector<WordEntry> result;
+        for (std::uint64_t i = 0; i < header_.word_count && result.size() < limit; ++i) {
+            const auto entry = read<detail::RankEntry>(header_.ranking + i * sizeof(detail::RankEntry));
+            const std::string_view text = word(entry.word);
+            if (word_length(text, encoding()) >= minlen) {
+                result.push_back(WordEntry{text, entry.count});
+            }
+        }
+        return result;
+    }
+
+    std::vector<IndexedFile> load_files() const {
+        std::vector<IndexedFile> files(static_cast<std::size_t>(header_.file_count));
+        for (std::uint64_t i = 0; i < header_.file_count; ++i) {
+            const auto record = read<detail::FileRecord>(header_.files + i * sizeof(detail::FileRecord));
+            IndexedFile& file = files[static_cast<std::size_t>(i)];
+            file.path = std::string(string_at(record.path_offset, record.path_size));
+            file.size = record.size;
+            file.mtime = record.mtime;
+            file.tail_offset = record.tail_offset;
+            file.prefix_hash = record.prefix_hash;
+            file.counts.reserve(static_cast<std::size_t>(record.counts_size));
+            for (std::uint64_t j = 0; j < record.counts_size; ++j) {
+                const auto count = read<detail::FileCount>(
+                    header_.file_counts + (record.counts_begin + j) * sizeof(detail::FileCount));
+                file.counts.increment(word(count.word), count.count);
+            }
+        }
+        return files;
+    }
+
+private:
+    template <typename T>
+    T read(std::uint64_t offset) const {
+        const std::string_view data = file_.view();
+        if (offset > data.size() || data.size() - offset < sizeof(T)) {
+            throw std::runtime_error("Corrupted index file");
+        }
+        T value;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        return value;
+    }
+
+    std::string_view string_at(std::uint64_t offset, std::uint64_t size) const {
+        if (offset > header_.strings_size || header_.strings_size - offset < size) {
+            throw std::runtime_error("Corrupted index file");
+        }
+        const std::uint64_t begin = header_.strings + offset;
+        const std::string_view data = file_.view();
+        if (begin > data.size() || data.size() - begin < size) {
+            throw std::runtime_error("Corrupted index file");
+        }
+        return data.substr(static_cast<std::size_t>(begin), static_cast<std::size_t>(size));
+    }
+
+    std::string_view word(std::uint32_t id) const {
+        if (id >= header_.word_count) {
+            throw std::runtime_error("Corrupted index file");
+        }
+        const auto begin = read<std::uint64_t>(header_.word_offsets + id * sizeof(std::uint64_t));
+        const auto end = read<std::uint64_t>(header_.word_offsets + (id + 1) * sizeof(std::uint64_t));
+        if (end < begin) {
+            throw std::runtime_error("Corrupted index file");
+        }
+        return string_at(begin, end - begin);
+    }
+
+    MappedFile file_;
+    detail::IndexHeader header_{};
+    bool exists_{false};
+};
+
+// Пишет индекс во временный файл и атомарно подменяет им старый.
+inline void save_index(const std::filesystem::path& index_path,
+                       std::size_t minlen,
+                       Encoding encoding,
+                       const std::vector<IndexedFile>& files,
+                       const WordTable& totals) {
+    std::vector<std::string_view> words;
+    std::vector<std::uint64_t> counts;
+    std::unordered_map<std::string_view, std::uint32_t> ids;
+    words.reserve(totals.size());
+    ids.reserve(totals.size());
+    totals.for_each([&](std::string_view word, std::uint64_t count) {
+        if (count != 0) {
+            ids.emplace(word, static_cast<std::uint32_t>(words.size()));
+            words.push_back(word);
+            counts.push_back(count);
+        }
+    });
+
+    std::vector<std::uint32_t> ranking(words.size());
+    for (std::size_t i = 0; i < ranking.size(); ++i) {
+        ranking[i] = static_cast<std::uint32_t>(i);
+    }
+    std::sort(ranking.begin(), ranking.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+        return ranks_before(WordEntry{words[lhs], counts[lhs]}, WordEntry{words[rhs], counts[rhs]});
+    });
+
+    std::string strings;
+    std::string word_offsets;
+    for (std::string_view word : words) {
+        detail::append_pod(word_offsets, static_cast<std::uint64_t>(strings.size()));
+        strings.append(word.data(), word.size());
+    }
+    detail::append_pod(word_offsets, static_cast<std::uint64_t>(strings.size()));
+
+    std::string records;
+    std::string file_counts;
+    std::uint64_t counts_total = 0;
+    for (const IndexedFile& file : files) {
+        const std::uint64_t counts_begin = counts_total;
+        file.counts.for_each([&](std::string_view word, std::uint64_t count) {
+            if (count != 0) {
+                detail::append_pod(file_counts, detail::FileCount{count, ids.at(word), 0});
+                ++counts_total;
+            }
+        });
+        detail::append_pod(records, detail::FileRecord{
+            file.size, file.mtime, file.tail_offset, file.prefix_hash,
+            strings.size(), file.path.size(), counts_begin, counts_total - counts_begin});
+        strings += file.path;
+    }
+
+    std::string ranking_bytes;
+    for (std::uint32_t id : ranking) {
+        detail::append_pod(ranking_bytes, detail::RankEntry{counts[id], id, 0});
+    }
+
+    detail::IndexHeader header{};
+    header.magic = detail::kIndexMagic;
+    header.version = detail::kIndexVersion;
+    header.minlen = static_cast<std::uint32_t>(minlen);
+    header.encoding = static_cast<std::uint32_t>(encoding);
+    header.word_count = words.size();
+    header.file_count = files.size();
+    header.word_offsets = sizeof(header);
+    header.ranking = header.word_offsets + word_offsets.size();
+    header.files = header.ranking + ranking_bytes.size();
+    header.file_counts = header.files + records.size();
+    header.strings = header.file_counts + file_counts.size();
+    header.strings_size = strings.size();
+
+    std::filesystem::path tmp_path = index_path;
+    tmp_path += ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Failed to write index file: " + tmp_path.string());
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const std::string* section : {&word_offsets, &ranking_bytes, &records, &file_counts, &strings}) {
+            out.write(section->data(), static_cast<std::streamsize>(section->size()));
+        }
+        if (!out) {
+            throw std::runtime_error("Failed to write index file: " + tmp_path.string());
+        }
+    }
+    std::filesystem::rename(tmp_path, index_path);
+}
+
+// Считает задачи с разбиением по файлам: результат задачи попадает в
+// files[task.file_id].counts. Задачи одного файла идут подряд, поэтому
+// worker сливает локальную таблицу, когда переходит к другому файлу.
+inline void count_per_file(const IndexerOptions& options,
+                           std::vector<Task> tasks,
+                           std::vector<IndexedFile>& files) {
+    TaskQueue queue;
+    for (Task& task : tasks) {
+        queue.push(std::move(task));
+    }
+    queue.close();
+
+    std::mutex files_mutex;
+    std::vector<std::thread> workers;
+    workers.reserve(options.threads);
+    for (std::size_t i = 0; i < options.threads; ++i) {
+        workers.emplace_back([&queue, &files, &files_mutex, &options] {
+            WordTable local;
+            std::size_t local_file = 0;
+            auto flush = [&] {
+                std::lock_guard<std::mutex> lock(files_mutex);
+                files[local_file].counts.absorb(local);
+            };
+
+            Task task;
+            while (queue.pop(task)) {
+                if (task.file_id != local_file && !local.empty()) {
+                    flush();
+                }
+                local_file = task.file_id;
+                process_file(task, options.io, options.minlen, options.encoding, local);
+            }
+            if (!local.empty()) {
+                flush();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// Загружает индекс, если он построен с тем же minlen и той же кодировкой.
+inline std::vector<IndexedFile> load_index(const std::filesystem::path& index_path,
+                                           std::size_t minlen,
+                                           Encoding encoding) {
+    const IndexView view(index_path);
+    if (!view.exists()) {
+        return {};
+    }
+    if (view.minlen() != minlen) {
+        std::cerr << "Index was built with --minlen " << view.minlen() << ", rebuilding\n";
+        return {};
+    }
+    if (view.encoding() != encoding) {
+        std::cerr << "Index was built in " << encoding_name(view.encoding()) << " mode, rebuilding\n";
+        return {};
+    }
+    return view.load_files();
+}
+
+// Приводит индекс в соответствие с каталогом: неизменённые файлы берутся
+// как есть, у дописанных обрабатывается только новый хвост, изменённые
+// и новые файлы пересчитываются целиком.
+inline std::vector<IndexedFile> update_index(const IndexerOptions& options,
+                                             const std::filesystem::path& input_dir,
+                                             std::vector<IndexedFile> previous,
+                                             IndexUpdateStats& stats) {
+    std::unordered_map<std::string, std::size_t> by_path;
+    for (std::size_t i = 0; i < previous.size(); ++i) {
+        by_path.emplace(previous[i].path, i);
+    }
+
+    std::vector<IndexedFile> files;
+    std::vector<Task> tasks;
+    std::string scratch;
+    // Файлы сортируются по пути, чтобы номера в индексе не зависели от
+    // порядка параллельного обхода.
+    std::mutex listed_mutex;
+    std::vector<std::pair<std::filesystem::path, std::uint64_t>> listed;
+    walk_directory(input_dir, WalkOptions{options.recursive, options.walkers},
+                   [&](const std::filesystem::path& path, std::uint64_t size) {
+                       std::lock_guard<std::mutex> lock(listed_mutex);
+                       listed.emplace_back(path, size);
+                   });
+    std::sort(listed.begin(), listed.end());
+
+    for (const auto& [path, size] : listed) {
+        const std::string relative = path.lexically_relative(input_dir).generic_string();
+        const std::int64_t mtime = detail::file_mtime(path);
+
+        IndexedFile file;
+        std::uint64_t scan_from = 0;
+        const auto found = by_path.find(relative);
+        if (found != by_path.end()) {
+            IndexedFile& old = previous[found->second];
+            by_path.erase(found);
+
+            if (old.size == size && old.mtime == mtime) {
+                ++stats.unchanged;
+                files.push_back(std::move(old));
+                continue;
+            }
+            // Сжатый файл не продолжить с середины, его всегда пересчитываем.
+            if (size > old.size && detect_compression(path) == Compression::None &&
+                detail::prefix_hash(path, old.tail_offset) == old.prefix_hash) {
+                // Незаконченное слово в конце могло продолжиться: вычитаем
+                // его и пересчитываем файл начиная с tail_offset.
+                ++stats.appended;
+                file = std::move(old);
+                scan_from = file.tail_offset;
+                const MappedFile mapped(path);
+                const std::string_view tail = mapped.view().substr(
+                    static_cast<std::size_t>(std::min<std::uint64_t>(scan_from, mapped.size())),
+                    static_cast<std::size_t>(file.size - scan_from));
+                tokenize(tail, options.minlen, options.encoding, scratch, [&file](std::string_view word) {
+                    file.counts.subtract(word, 1);
+                });
+            } else {
+                ++stats.rescanned;
+            }
+        } else {
+            ++stats.rescanned;
+        }
+
+        file.path = relative;
+        file.size = size;
+        file.mtime = mtime;
+        file.tail_offset = detail::find_tail_offset(path, size);
+        file.prefix_hash = detail::prefix_hash(path, file.tail_offset);
+
+        const std::size_t file_id = files.size();
+        split_range(path, scan_from, size, options.chunk_bytes, [&tasks, file_id](Task task) {
+            task.file_id = file_id;
+            tasks.push_back(std::move(task));
+        });
+        files.push_back(std::move(file));
+    }
+    stats.removed = by_path.size();
+
+    count_per_file(options, std::move(tasks), files);
+    return files;
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "global_counts.hpp"
+
+// Живые счётчики одного worker'а. Пишет только владелец (relaxed), читает
+// репортёр; выравнивание убирает ложное разделение кэш-линий.
+struct alignas(64) WorkerProgress {
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> files{0};  // файлов, досчитанных этим worker'ом
+    std::atomic<std::uint64_t> tasks{0};
+    std::atomic<std::uint64_t> tokens{0};
+    std::atomic<std::uint64_t> words{0};   // различных слов в локальной таблице
+    std::atomic<std::uint64_t> memory{0};  // оценка памяти локальной таблицы
+};
+
+struct ProgressTotals {
+    std::uint64_t bytes = 0;
+    std::uint64_t files = 0;
+    std::uint64_t tasks = 0;
+    std::uint64_t tokens = 0;
+    std::uint64_t local_words = 0;
+    std::uint64_t local_memory = 0;
+};
+
+class IndexerProgress {
+public:
+    explicit IndexerProgress(std::size_t workers)
+        : workers_(workers), progress_(std::make_unique<WorkerProgress[]>(workers)) {}
+
+    WorkerProgress& worker(std::size_t index) {
+        return progress_[index];
+    }
+
+    // Producer: сколько файлов, байт и задач найдено при обходе.
+    void add_found_file() {
+        found_files_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void add_found(std::uint64_t bytes) {
+        found_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        found_tasks_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void finish_walk() {
+        walk_done_.store(true, std::memory_order_relaxed);
+    }
+
+    std::uint64_t found_bytes() const {
+        return found_bytes_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t found_files() const {
+        return found_files_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t found_tasks() const {
+        return found_tasks_.load(std::memory_order_relaxed);
+    }
+
+    bool walk_done() const {
+        return walk_done_.load(std::memory_order_relaxed);
+    }
+
+    ProgressTotals totals() const {
+        ProgressTotals totals;
+        for (std::size_t i = 0; i < workers_; ++i) {
+            const WorkerProgress& worker = progress_[i];
+            totals.bytes += worker.bytes.load(std::memory_order_relaxed);
+            totals.files += worker.files.load(std::memory_order_relaxed);
+            totals.tasks += worker.tasks.load(std::memory_order_relaxed);
+            totals.tokens += worker.tokens.load(std::memory_order_relaxed);
+            totals.local_words += worker.words.load(std::memory_order_relaxed);
+            totals.local_memory += worker.memory.load(std::memory_order_relaxed);
+        }
+        return totals;
+    }
+
+private:
+    std::size_t workers_;
+    std::unique_ptr<WorkerProgress[]> progress_;
+    std::atomic<std::uint64_t> found_files_{0};
+    std::atomic<std::uint64_t> found_bytes_{0};
+    std::atomic<std::uint64_t> found_tasks_{0};
+    std::atomic<bool> walk_done_{false};
+};
+
+// Раз в interval печатает в stderr строку прогресса; последняя строка —
+// при остановке. Без interval (ноль) поток не запускается.
+class ProgressReporter {
+public:
+    ProgressReporter(const IndexerProgress& progress,
+                     const GlobalCounts& global,
+                     std::chrono::milliseconds interval)
+        : progress_(progress), global_(global), interval_(interval), started_(Clock::now()) {
+        if (interval_.count() > 0) {
+            thread_ = std::thread([this] { run(); });
+        }
+    }
+
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+    ~ProgressReporter() {
+        stop();
+    }
+
+    void stop() {
+        if (!thread_.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+        report();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!cv_.wait_for(lock, interval_, [this] { return stopped_; })) {
+            report();
+        }
+    }
+
+    void report() {
+        constexpr double kMiB = 1024.0 * 1024.0;
+        const ProgressTotals totals = progress_.totals();
+        const double seconds = std::chrono::duration<double>(Clock::now() - started_).count();
+        const double interval_seconds = std::chrono::duration<double>(Clock::now() - last_time_).count();
+        const double rate = last_time_ == Clock::time_point()
+            ? totals.bytes / kMiB / seconds
+            : (totals.bytes - last_bytes_) / kMiB / interval_seconds;
+        last_time_ = Clock::now();
+        last_bytes_ = totals.bytes;
+
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(1) << '[' << seconds << "s] "
+             << totals.bytes / kMiB << " MiB";
+        if (progress_.walk_done() && progress_.found_bytes() > 0) {
+            line << " of " << progress_.found_bytes() / kMiB << " MiB ("
+                 << 100.0 * totals.bytes / progress_.found_bytes() << "%)";
+        } else {
+            line << " of " << progress_.found_bytes() / kMiB << "+ MiB found";
+        }
+        line << ", " << rate << " MiB/s, " << totals.files << '/' << progress_.found_files() << " files, "
+             << totals.tasks << '/' << progress_.found_tasks() << " tasks, "
+             << totals.tokens << " tokens, " << totals.local_words << " local words, mem ~"
+             << (totals.local_memory + global_.memory_bytes()) / kMiB << " MiB";
+        std::cerr << line.str() << '\n';
+    }
+
+    const IndexerProgress& progress_;
+    const GlobalCounts& global_;
+    std::chrono::milliseconds interval_;
+    Clock::time_point started_;
+    Clock::time_point last_time_{};
+    std::uint64_t last_bytes_{0};
+
+    bool stopped_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+};
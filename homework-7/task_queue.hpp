@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// Диапазон байт [offset, offset + length) одного файла.
+// Большие файлы режутся producer'ом на несколько таких задач.
+struct Task {
+    static constexpr std::uint64_t kWholeFile = std::numeric_limits<std::uint64_t>::max();
+
+    std::filesystem::path path;
+    std::uint64_t offset = 0;
+    std::uint64_t length = kWholeFile;
+    std::size_t file_id = 0;  // номер файла в постоянном индексе
+    // Ещё не посчитанные байты файла, общие для всех его задач: кто довёл
+    // их до нуля, тот и закончил файл. Пусто — файл не отслеживается.
+    std::shared_ptr<std::atomic<std::uint64_t>> file_left;
+};
+
+class TaskQueue {
+public:
+    // false — очередь отменена, задача не принята.
+    bool push(Task task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (cancelled_) {
+                return false;
+            }
+            queue_.push(std::move(task));
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    bool pop(Task& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return false;
+        }
+        out = std::move(queue_.front());
+        queue_.pop();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    // Закрывает очередь и возвращает задачи, которые никто не успел взять.
+    // Workers доделывают текущую задачу, и pop у них вернёт false.
+    std::vector<Task> cancel() {
+        std::vector<Task> dropped;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cancelled_ = true;
+            closed_ = true;
+            dropped.reserve(queue_.size());
+            while (!queue_.empty()) {
+                dropped.push_back(std::move(queue_.front()));
+                queue_.pop();
+            }
+        }
+        cv_.notify_all();
+        return dropped;
+    }
+
+private:
+    std::queue<Task> queue_;
+    bool closed_{false};
+    bool cancelled_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
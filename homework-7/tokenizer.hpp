@@ -0,0 +1,728 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define HOMEWORK7_HAVE_SIMD 1
+#endif
+
+namespace detail {
+
+// Классы символов без обращения к locale: 1 — символ слова [A-Za-z0-9_],
+// 2 — заглавная латинская буква.
+constexpr std::uint8_t kWordChar = 1;
+constexpr std::uint8_t kUpperChar = 2;
+
+constexpr std::array<std::uint8_t, 256> make_char_classes() {
+    std::array<std::uint8_t, 256> table{};
+    for (int c = '0'; c <= '9'; ++c) {
+        table[static_cast<std::size_t>(c)] = kWordChar;
+    }
+    for (int c = 'a'; c <= 'z'; ++c) {
+        table[static_cast<std::size_t>(c)] = kWordChar;
+    }
+    for (int c = 'A'; c <= 'Z'; ++c) {
+        table[static_cast<std::size_t>(c)] = kWordChar | kUpperChar;
+    }
+    table[static_cast<std::size_t>('_')] = kWordChar;
+    return table;
+}
+
+constexpr std::array<std::uint8_t, 256> kCharClasses = make_char_classes();
+
+}  // namespace detail
+
+inline bool is_word_char(unsigned char c) {
+    return (detail::kCharClasses[c] & detail::kWordChar) != 0;
+}
+
+inline bool is_upper_char(unsigned char c) {
+    return (detail::kCharClasses[c] & detail::kUpperChar) != 0;
+}
+
+// Байт, на котором текст можно резать при любой кодировке: ASCII-символ
+// не слова. Байт >= 0x80 в режиме UTF-8 может оказаться частью буквы.
+inline bool is_separator_byte(unsigned char c) {
+    return c < 0x80 && !is_word_char(c);
+}
+
+inline char to_lower_char(char c) {
+    return is_upper_char(static_cast<unsigned char>(c)) ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+// Копирует n байт из src в dst, переводя A-Z в нижний регистр.
+inline void lowercase_ascii(const char* src, std::size_t n, char* dst) {
+    std::size_t i = 0;
+#if defined(HOMEWORK7_HAVE_SIMD)
+    const __m128i before_a = _mm_set1_epi8('A' - 1);
+    const __m128i after_z = _mm_set1_epi8('Z' + 1);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, before_a), _mm_cmplt_epi8(v, after_z));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(v, _mm_and_si128(upper, case_bit)));
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] = to_lower_char(src[i]);
+    }
+}
+
+// Вызывает sink(word) для каждого слова длиной не меньше minlen.
+// word — это string_view в нижнем регистре: он указывает прямо в text,
+// а если в слове были заглавные буквы — в scratch. Ссылка действительна
+// только до следующего вызова sink.
+//
+// Побайтовая эталонная версия.
+template <typename Sink>
+void tokenize_scalar(std::string_view text, std::size_t minlen, std::string& scratch, Sink&& sink) {
+    const std::size_t size = text.size();
+    std::size_t pos = 0;
+
+    while (pos < size) {
+        while (pos < size && !is_word_char(static_cast<unsigned char>(text[pos]))) {
+            ++pos;
+        }
+
+        const std::size_t begin = pos;
+        bool has_upper = false;
+        while (pos < size && is_word_char(static_cast<unsigned char>(text[pos]))) {
+            has_upper = has_upper || is_upper_char(static_cast<unsigned char>(text[pos]));
+            ++pos;
+        }
+
+        const std::size_t length = pos - begin;
+        if (length == 0 || length < minlen) {
+            continue;
+        }
+
+        std::string_view word = text.substr(begin, length);
+        if (has_upper) {
+            scratch.resize(length);
+            lowercase_ascii(word.data(), length, scratch.data());
+            word = scratch;
+        }
+        sink(word);
+    }
+}
+
+namespace detail {
+
+constexpr std::size_t kTokenBlock = 64;
+
+// Битовые маски блока из 64 байт: бит i соответствует байту i.
+struct BlockMasks {
+    std::uint64_t word = 0;
+    std::uint64_t upper = 0;
+};
+
+inline unsigned count_trailing_zeros(std::uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(value));
+#else
+    unsigned count = 0;
+    while ((value & 1) == 0) {
+        value >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+#if defined(__AVX2__)
+inline BlockMasks classify_32(const char* p) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    // Байты >= 0x80 отрицательны в знаковом сравнении и никуда не попадают.
+    const __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                           _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+    const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)),
+                                           _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+    const __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+    const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)),
+                                           _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+    const __m256i word = _mm256_or_si256(_mm256_or_si256(alpha, digit), underscore);
+
+    BlockMasks masks;
+    masks.word = static_cast<std::uint32_t>(_mm256_movemask_epi8(word));
+    masks.upper = static_cast<std::uint32_t>(_mm256_movemask_epi8(upper));
+    return masks;
+}
+#elif defined(HOMEWORK7_HAVE_SIMD)
+inline BlockMasks classify_16(const char* p) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    // Байты >= 0x80 отрицательны в знаковом сравнении и никуда не попадают.
+    const __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                        _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                        _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    const __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                                        _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+    const __m128i word = _mm_or_si128(_mm_or_si128(alpha, digit), underscore);
+
+    BlockMasks masks;
+    masks.word = static_cast<std::uint32_t>(_mm_movemask_epi8(word));
+    masks.upper = static_cast<std::uint32_t>(_mm_movemask_epi8(upper));
+    return masks;
+}
+#endif
+
+inline BlockMasks classify_block(const char* p) {
+    BlockMasks masks;
+#if defined(__AVX2__)
+    for (std::size_t i = 0; i < kTokenBlock; i += 32) {
+        const BlockMasks part = classify_32(p + i);
+        masks.word |= part.word << i;
+        masks.upper |= part.upper << i;
+    }
+#elif defined(HOMEWORK7_HAVE_SIMD)
+    for (std::size_t i = 0; i < kTokenBlock; i += 16) {
+        const BlockMasks part = classify_16(p + i);
+        masks.word |= part.word << i;
+        masks.upper |= part.upper << i;
+    }
+#else
+    for (std::size_t i = 0; i < kTokenBlock; ++i) {
+        const std::uint8_t cls = kCharClasses[static_cast<unsigned char>(p[i])];
+        masks.word |= static_cast<std::uint64_t>(cls & kWordChar) << i;
+        masks.upper |= static_cast<std::uint64_t>((cls & kUpperChar) >> 1) << i;
+    }
+#endif
+    return masks;
+}
+
+}  // namespace detail
+
+// Блочная версия: текст классифицируется по 64 байта (SSE2 или AVX2),
+// границы слов находятся по битовым маскам. Результат совпадает с
+// tokenize_scalar.
+template <typename Sink>
+void tokenize_simd(std::string_view text, std::size_t minlen, std::string& scratch, Sink&& sink) {
+    using detail::kTokenBlock;
+
+    const char* data = text.data();
+    const std::size_t size = text.size();
+
+    auto emit = [&](std::size_t begin, std::size_t end, bool has_upper) {
+        const std::size_t length = end - begin;
+        if (length < minlen) {
+            return;
+        }
+        if (!has_upper) {
+            sink(std::string_view(data + begin, length));
+            return;
+        }
+        scratch.resize(length);
+        lowercase_ascii(data + begin, length, scratch.data());
+        sink(std::string_view(scratch));
+    };
+
+    bool in_token = false;
+    bool has_upper = false;
+    std::size_t token_begin = 0;
+    char tail[kTokenBlock];
+
+    for (std::size_t base = 0; base < size; base += kTokenBlock) {
+        detail::BlockMasks masks;
+        if (size - base >= kTokenBlock) {
+            masks = detail::classify_block(data + base);
+        } else {
+            // Хвост дополняется нулями, а ноль — разделитель.
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, data + base, size - base);
+            masks = detail::classify_block(tail);
+        }
+
+        std::size_t pos = 0;
+        while (pos < kTokenBlock) {
+            const std::uint64_t from_pos = ~0ull << pos;
+            if (!in_token) {
+                const std::uint64_t starts = masks.word & from_pos;
+                if (starts == 0) {
+                    break;
+                }
+                pos = detail::count_trailing_zeros(starts);
+                token_begin = base + pos;
+                in_token = true;
+                has_upper = false;
+                continue;
+            }
+
+            const std::uint64_t ends = ~masks.word & from_pos;
+            if (ends == 0) {
+                has_upper = has_upper || (masks.upper & from_pos) != 0;
+                break;
+            }
+            const std::size_t end = detail::count_trailing_zeros(ends);
+            has_upper = has_upper || (masks.upper & from_pos & ((1ull << end) - 1)) != 0;
+            emit(token_begin, base + end, has_upper);
+            in_token = false;
+            pos = end;
+        }
+    }
+
+    if (in_token) {
+        emit(token_begin, size, has_upper);
+    }
+}
+
+template <typename Sink>
+void tokenize(std::string_view text, std::size_t minlen, std::string& scratch, Sink&& sink) {
+#if defined(HOMEWORK7_HAVE_SIMD)
+    tokenize_simd(text, minlen, scratch, sink);
+#else
+    tokenize_scalar(text, minlen, scratch, sink);
+#endif
+}
+
+// Режим --utf8. Слово — непрерывная последовательность букв и цифр
+// Unicode (плюс '_'), в нижнем регистре по простой свёртке (CaseFolding,
+// статус C): латиница с диакритикой, греческий, кириллица, армянский.
+// Для символов U+0080..U+07FF класс и свёртка берутся из таблицы; трёх-
+// и четырёхбайтовые символы считаются буквами без свёртки, кроме блоков
+// знаков препинания и символов (U+2000..U+2BFF, U+3000..U+303F, эмодзи и
+// т.п.). Некорректные последовательности — разделители. minlen считается
+// в символах, а не в байтах.
+namespace detail {
+
+// Длина последовательности UTF-8 по первому байту; 0 — байт не может
+// начинать символ (продолжение, C0/C1, F5..FF).
+constexpr std::array<std::uint8_t, 256> make_utf8_lengths() {
+    std::array<std::uint8_t, 256> table{};
+    for (std::size_t c = 0; c < 0x80; ++c) {
+        table[c] = 1;
+    }
+    for (std::size_t c = 0xC2; c < 0xE0; ++c) {
+        table[c] = 2;
+    }
+    for (std::size_t c = 0xE0; c < 0xF0; ++c) {
+        table[c] = 3;
+    }
+    for (std::size_t c = 0xF0; c < 0xF5; ++c) {
+        table[c] = 4;
+    }
+    return table;
+}
+
+constexpr std::array<std::uint8_t, 256> kUtf8Lengths = make_utf8_lengths();
+
+constexpr std::size_t kFoldTableSize = 0x800;
+using FoldTable = std::array<std::uint16_t, kFoldTableSize>;
+
+// [first, last] переходят в cp + delta.
+constexpr void fold_range(FoldTable& table, std::uint32_t first, std::uint32_t last, std::uint32_t delta) {
+    for (std::uint32_t cp = first; cp <= last; ++cp) {
+        table[cp] = static_cast<std::uint16_t>(cp + delta);
+    }
+}
+
+// Пары «заглавная, строчная» подряд начиная с first.
+constexpr void fold_pairs(FoldTable& table, std::uint32_t first, std::uint32_t last) {
+    for (std::uint32_t cp = first; cp < last; cp += 2) {
+        table[cp] = static_cast<std::uint16_t>(cp + 1);
+    }
+}
+
+constexpr void clear_range(FoldTable& table, std::uint32_t first, std::uint32_t last) {
+    for (std::uint32_t cp = first; cp <= last; ++cp) {
+        table[cp] = 0;
+    }
+}
+
+// Символы U+0080..U+07FF: 0 — не символ слова (знаки, пробелы, валюты),
+// иначе код символа после свёртки регистра.
+constexpr FoldTable make_fold_table() {
+    FoldTable table{};
+    // Всё от U+00C0 — буквы и комбинируемые знаки, по умолчанию без пары.
+    for (std::uint32_t cp = 0xC0; cp < kFoldTableSize; ++cp) {
+        table[cp] = static_cast<std::uint16_t>(cp);
+    }
+    table[0xAA] = 0xAA;
+    table[0xB5] = 0x3BC;
+    table[0xBA] = 0xBA;
+
+    // Латиница.
+    fold_range(table, 0xC0, 0xDE, 0x20);
+    fold_pairs(table, 0x100, 0x12F);
+    fold_pairs(table, 0x132, 0x137);
+    fold_pairs(table, 0x139, 0x148);
+    fold_pairs(table, 0x14A, 0x177);
+    table[0x178] = 0xFF;
+    fold_pairs(table, 0x179, 0x17E);
+    table[0x17F] = 's';
+    table[0x1C4] = table[0x1C5] = 0x1C6;
+    table[0x1C7] = table[0x1C8] = 0x1C9;
+    table[0x1CA] = table[0x1CB] = 0x1CC;
+    fold_pairs(table, 0x1CD, 0x1DC);
+    fold_pairs(table, 0x1DE, 0x1EF);
+    table[0x1F1] = table[0x1F2] = 0x1F3;
+    fold_pairs(table, 0x1F4, 0x1F5);
+    fold_pairs(table, 0x1F8, 0x21F);
+    fold_pairs(table, 0x222, 0x233);
+    fold_pairs(table, 0x246, 0x24F);
+
+    // Греческий.
+    fold_pairs(table, 0x370, 0x373);
+    fold_pairs(table, 0x376, 0x377);
+    table[0x37F] = 0x3F3;
+    table[0x386] = 0x3AC;
+    fold_range(table, 0x388, 0x38A, 0x25);
+    table[0x38C] = 0x3CC;
+    fold_range(table, 0x38E, 0x38F, 0x3F);
+    fold_range(table, 0x391, 0x3A1, 0x20);
+    fold_range(table, 0x3A3, 0x3AB, 0x20);
+    table[0x3C2] = 0x3C3;
+    fold_pairs(table, 0x3D8, 0x3EF);
+
+    // Кириллица.
+    fold_range(table, 0x400, 0x40F, 0x50);
+    fold_range(table, 0x410, 0x42F, 0x20);
+    fold_pairs(table, 0x460, 0x481);
+    fold_pairs(table, 0x48A, 0x4BF);
+    table[0x4C0] = 0x4CF;
+    fold_pairs(table, 0x4C1, 0x4CE);
+    fold_pairs(table, 0x4D0, 0x52F);
+
+    // Армянский.
+    fold_range(table, 0x531, 0x556, 0x30);
+
+    // Знаки, которые не входят в слова.
+    table[0xD7] = 0;
+    table[0xF7] = 0;
+    clear_range(table, 0x2C2, 0x2C5);
+    clear_range(table, 0x2D2, 0x2DF);
+    clear_range(table, 0x2E5, 0x2EB);
+    clear_range(table, 0x2EF, 0x2FF);
+    table[0x375] = 0;
+    table[0x37E] = 0;
+    clear_range(table, 0x384, 0x385);
+    table[0x387] = 0;
+    table[0x3F6] = 0;
+    table[0x482] = 0;
+    clear_range(table, 0x55A, 0x55F);
+    clear_range(table, 0x589, 0x58F);
+    table[0x5BE] = 0;
+    table[0x5C0] = 0;
+    table[0x5C3] = 0;
+    table[0x5C6] = 0;
+    clear_range(table, 0x5F3, 0x5F4);
+    clear_range(table, 0x600, 0x60F);
+    clear_range(table, 0x61B, 0x61F);
+    clear_range(table, 0x66A, 0x66D);
+    table[0x6D4] = 0;
+    table[0x6DD] = 0;
+    table[0x6DE] = 0;
+    table[0x6E9] = 0;
+    clear_range(table, 0x6FD, 0x6FE);
+    clear_range(table, 0x700, 0x70F);
+    clear_range(table, 0x7F6, 0x7F9);
+    clear_range(table, 0x7FE, 0x7FF);
+    return table;
+}
+
+constexpr FoldTable kFoldTable = make_fold_table();
+
+// 0 — не символ слова, иначе код после свёртки регистра.
+inline std::uint32_t fold_code_point(std::uint32_t cp) {
+    if (cp < 0x80) {
+        const std::uint8_t cls = kCharClasses[cp];
+        return (cls & kUpperChar) != 0 ? cp + ('a' - 'A') : (cls & kWordChar) != 0 ? cp : 0;
+    }
+    if (cp < kFoldTableSize) {
+        return kFoldTable[cp];
+    }
+    // Пунктуация, символы, стрелки, рамки, CJK-пунктуация, BOM,
+    // полноширинные знаки, частная область, эмодзи.
+    if ((cp >= 0x2000 && cp <= 0x2BFF) || (cp >= 0x3000 && cp <= 0x303F) || (cp >= 0xE000 && cp <= 0xF8FF) ||
+        (cp >= 0xFE30 && cp <= 0xFE4F) || cp == 0xFEFF || (cp >= 0xFF00 && cp <= 0xFF0F) ||
+        (cp >= 0x1F000 && cp <= 0x1FAFF)) {
+        return 0;
+    }
+    // Вьетнамская латиница и полноширинные A-Z.
+    if ((cp >= 0x1E00 && cp <= 0x1E95) || (cp >= 0x1EA0 && cp <= 0x1EFF)) {
+        return cp % 2 == 0 ? cp + 1 : cp;
+    }
+    if (cp >= 0xFF21 && cp <= 0xFF3A) {
+        return cp + 0x20;
+    }
+    return cp;
+}
+
+// Декодирует символ в начале [p, p + avail). Возвращает длину
+// последовательности или 0, если она некорректна: обрезана, overlong,
+// суррогат или больше U+10FFFF.
+inline std::size_t decode_utf8(const unsigned char* p, std::size_t avail, std::uint32_t& cp) {
+    const std::size_t length = kUtf8Lengths[p[0]];
+    if (length == 0 || length > avail) {
+        return 0;
+    }
+    for (std::size_t i = 1; i < length; ++i) {
+        if ((p[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    switch (length) {
+        case 1:
+            cp = p[0];
+            return 1;
+        case 2:
+            cp = (static_cast<std::uint32_t>(p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+            return 2;
+        case 3:
+            cp = (static_cast<std::uint32_t>(p[0] & 0x0F) << 12) | (static_cast<std::uint32_t>(p[1] & 0x3F) << 6) |
+                 (p[2] & 0x3F);
+            return cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF) ? 0 : 3;
+        default:
+            cp = (static_cast<std::uint32_t>(p[0] & 0x07) << 18) | (static_cast<std::uint32_t>(p[1] & 0x3F) << 12) |
+                 (static_cast<std::uint32_t>(p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+            return cp < 0x10000 || cp > 0x10FFFF ? 0 : 4;
+    }
+}
+
+inline void append_utf8(std::string& out, std::uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+// Копирует слово [src, src + n) в out со свёрткой регистра. Слово уже
+// проверено токенизатором: в нём только корректные символы слова.
+inline void fold_utf8(const char* src, std::size_t n, std::string& out) {
+    const auto* p = reinterpret_cast<const unsigned char*>(src);
+    out.clear();
+    for (std::size_t i = 0; i < n;) {
+        std::uint32_t cp = 0;
+        i += decode_utf8(p + i, n - i, cp);
+        append_utf8(out, fold_code_point(cp));
+    }
+}
+
+// Есть ли в 64 байтах блока байт >= 0x80.
+inline bool has_high_bytes(const char* p) {
+#if defined(__AVX2__)
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+    return _mm256_movemask_epi8(_mm256_or_si256(a, b)) != 0;
+#elif defined(HOMEWORK7_HAVE_SIMD)
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+    const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 48));
+    return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) != 0;
+#else
+    std::uint64_t any = 0;
+    for (std::size_t i = 0; i < kTokenBlock; i += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        std::memcpy(&word, p + i, sizeof(word));
+        any |= word;
+    }
+    return (any & 0x8080808080808080ull) != 0;
+#endif
+}
+
+}  // namespace detail
+
+// Посимвольная эталонная версия режима UTF-8: каждое слово собирается
+// в scratch заново.
+template <typename Sink>
+void tokenize_utf8_scalar(std::string_view text, std::size_t minlen, std::string& scratch, Sink&& sink) {
+    const auto* data = reinterpret_cast<const unsigned char*>(text.data());
+    const std::size_t size = text.size();
+    std::size_t chars = 0;
+
+    auto flush = [&] {
+        if (chars != 0 && chars >= minlen) {
+            sink(std::string_view(scratch));
+        }
+        scratch.clear();
+        chars = 0;
+    };
+
+    scratch.clear();
+    std::size_t pos = 0;
+    while (pos < size) {
+        std::uint32_t cp = 0;
+        const std::size_t length = detail::decode_utf8(data + pos, size - pos, cp);
+        const std::uint32_t folded = length == 0 ? 0 : detail::fold_code_point(cp);
+        if (folded == 0) {
+            flush();
+            pos += length == 0 ? 1 : length;
+            continue;
+        }
+        detail::append_utf8(scratch, folded);
+        ++chars;
+        pos += length;
+    }
+    flush();
+}
+
+// Блочная версия режима UTF-8. Блок из 64 байт сначала проверяется на
+// байты >= 0x80 одним movemask; чистый ASCII разбирается по маскам, как в
+// tokenize_simd, и только блоки с такими байтами декодируются
+// посимвольно. Слово указывает в text, если свёртка его не меняет.
+// Результат совпадает с tokenize_utf8_scalar.
+template <typename Sink>
+void tokenize_utf8(std::string_view text, std::size_t minlen, std::string& scratch, Sink&& sink) {
+    using detail::kTokenBlock;
+
+    const char* data = text.data();
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+    const std::size_t size = text.size();
+
+    bool in_token = false;
+    bool needs_fold = false;
+    std::size_t continuation = 0;  // байтов продолжения: символов = байт - continuation
+    std::size_t token_begin = 0;
+
+    auto start = [&](std::size_t begin) {
+        in_token = true;
+        needs_fold = false;
+        continuation = 0;
+        token_begin = begin;
+    };
+
+    auto emit = [&](std::size_t end) {
+        in_token = false;
+        const std::size_t length = end - token_begin;
+        if (length - continuation < minlen) {
+            return;
+        }
+        if (!needs_fold) {
+            sink(std::string_view(data + token_begin, length));
+            return;
+        }
+        if (continuation == 0) {
+            scratch.resize(length);
+            lowercase_ascii(data + token_begin, length, scratch.data());
+        } else {
+            detail::fold_utf8(data + token_begin, length, scratch);
+        }
+        sink(std::string_view(scratch));
+    };
+
+    // Блок без байтов >= 0x80 — те же маски, что в tokenize_simd.
+    auto ascii_block = [&](std::size_t base, const detail::BlockMasks& masks) {
+        std::size_t pos = 0;
+        while (pos < kTokenBlock) {
+            const std::uint64_t from_pos = ~0ull << pos;
+            if (!in_token) {
+                const std::uint64_t starts = masks.word & from_pos;
+                if (starts == 0) {
+                    break;
+                }
+                pos = detail::count_trailing_zeros(starts);
+                start(base + pos);
+                continue;
+            }
+
+            const std::uint64_t ends = ~masks.word & from_pos;
+            if (ends == 0) {
+                needs_fold = needs_fold || (masks.upper & from_pos) != 0;
+                break;
+            }
+            const std::size_t end = detail::count_trailing_zeros(ends);
+            needs_fold = needs_fold || (masks.upper & from_pos & ((1ull << end) - 1)) != 0;
+            emit(base + end);
+            pos = end;
+        }
+    };
+
+    // Посимвольный разбор с pos до until; последний символ может выйти
+    // за until, возвращается позиция после него.
+    auto decode_until = [&](std::size_t pos, std::size_t until) {
+        while (pos < until) {
+            std::uint32_t cp = 0;
+            std::size_t length = detail::decode_utf8(bytes + pos, size - pos, cp);
+            const std::uint32_t folded = length == 0 ? 0 : detail::fold_code_point(cp);
+            if (folded == 0) {
+                if (in_token) {
+                    emit(pos);
+                }
+                pos += length == 0 ? 1 : length;
+                continue;
+            }
+            if (!in_token) {
+                start(pos);
+            }
+            continuation += length - 1;
+            needs_fold = needs_fold || folded != cp;
+            pos += length;
+        }
+        return pos;
+    };
+
+    char tail[kTokenBlock];
+    std::size_t pos = 0;
+    while (pos < size) {
+        const char* block = data + pos;
+        if (size - pos < kTokenBlock) {
+            // Хвост дополняется нулями, а ноль — разделитель.
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, data + pos, size - pos);
+            block = tail;
+        }
+        if (!detail::has_high_bytes(block)) {
+            ascii_block(pos, detail::classify_block(block));
+            pos += kTokenBlock;
+        } else {
+            pos = decode_until(pos, std::min(size, pos + kTokenBlock));
+        }
+    }
+
+    if (in_token) {
+        emit(size);
+    }
+}
+
+// Ascii — слова [A-Za-z0-9_], любой байт >= 0x80 разделяет слова;
+// Utf8 — режим --utf8, см. tokenize_utf8.
+enum class Encoding {
+    Ascii,
+    Utf8,
+};
+
+inline const char* encoding_name(Encoding encoding) {
+    return encoding == Encoding::Utf8 ? "utf8" : "ascii";
+}
+
+// Длина слова в тех же единицах, что и minlen: байты или символы.
+inline std::size_t word_length(std::string_view word, Encoding encoding) {
+    if (encoding == Encoding::Ascii) {
+        return word.size();
+    }
+    std::size_t chars = 0;
+    for (char c : word) {
+        chars += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+    }
+    return chars;
+}
+
+template <typename Sink>
+void tokenize(std::string_view text, std::size_t minlen, Encoding encoding, std::string& scratch, Sink&& sink) {
+    if (encoding == Encoding::Utf8) {
+        tokenize_utf8(text, minlen, scratch, sink);
+    } else {
+        tokenize(text, minlen, scratch, sink);
+    }
+}
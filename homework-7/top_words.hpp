@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "global_counts.hpp"
+#include "word_table.hpp"
+
+struct WordEntry {
+    std::string_view word;
+    std::uint64_t count = 0;
+};
+
+// Порядок вывода: по убыванию частоты, при равенстве — по слову.
+inline bool ranks_before(const WordEntry& lhs, const WordEntry& rhs) {
+    if (lhs.count != rhs.count) {
+        return lhs.count > rhs.count;
+    }
+    return lhs.word < rhs.word;
+}
+
+// Потоковый отбор limit лучших слов: куча ограниченного размера, в вершине
+// которой худший из отобранных. O(n log M) времени и O(M) памяти вместо
+// копирования и полной сортировки всего словаря. Слова не копируются —
+// string_view указывают на ключи глобального словаря.
+class TopWords {
+public:
+    // words — сколько разных слов будет предложено (если известно): куча
+    // не больше него, так что огромный --top не резервирует память зря.
+    explicit TopWords(std::size_t limit, std::size_t words = 0) : limit_(limit) {
+        heap_.reserve(std::min(limit_, words));
+    }
+
+    void offer(std::string_view word, std::uint64_t count) {
+        const WordEntry entry{word, count};
+        if (count == 0) {
+            return;
+        }
+        if (heap_.size() < limit_) {
+            heap_.push_back(entry);
+            std::push_heap(heap_.begin(), heap_.end(), ranks_before);
+        } else if (limit_ != 0 && ranks_before(entry, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), ranks_before);
+            heap_.back() = entry;
+            std::push_heap(heap_.begin(), heap_.end(), ranks_before);
+        }
+    }
+
+    void merge(const TopWords& other) {
+        for (const auto& entry : other.heap_) {
+            offer(entry.word, entry.count);
+        }
+    }
+
+    std::vector<WordEntry> take_sorted() {
+        std::sort_heap(heap_.begin(), heap_.end(), ranks_before);
+        return std::move(heap_);
+    }
+
+private:
+    std::size_t limit_;
+    std::vector<WordEntry> heap_;
+};
+
+inline std::vector<WordEntry> select_top(const WordTable& counts, std::size_t limit) {
+    TopWords top(limit, counts.size());
+    counts.for_each([&top](std::string_view word, std::uint64_t count) {
+        top.offer(word, count);
+    });
+    return top.take_sorted();
+}
+
+// Отбирает limit лучших слов. Сегменты глобального словаря обрабатываются
+// параллельно (до threads потоков), затем их кучи сливаются.
+inline std::vector<WordEntry> select_top(const GlobalCounts& global,
+                                         std::size_t limit,
+                                         std::size_t threads) {
+    const std::size_t shard_count = global.shard_count();
+    threads = std::max<std::size_t>(1, std::min(threads, shard_count));
+
+    std::vector<TopWords> partial;
+    partial.reserve(threads);
+    for (std::size_t worker = 0; worker < threads; ++worker) {
+        std::size_t words = 0;
+        for (std::size_t shard = worker; shard < shard_count; shard += threads) {
+            words += global.shard(shard).size();
+        }
+        partial.emplace_back(limit, words);
+    }
+    auto select_shards = [&global, &partial, threads, shard_count](std::size_t worker) {
+        for (std::size_t shard = worker; shard < shard_count; shard += threads) {
+            global.shard(shard).for_each([&partial, worker](std::string_view word, std::uint64_t count) {
+                partial[worker].offer(word, count);
+            });
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (std::size_t i = 1; i < threads; ++i) {
+        workers.emplace_back(select_shards, i);
+    }
+    select_shards(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (std::size_t i = 1; i < threads; ++i) {
+        partial.front().merge(partial[i]);
+    }
+    return partial.front().take_sorted();
+}
@@ -0,0 +1,329 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Монотонный bump-аллокатор для байтов слов. Память освобождается только
+// целиком, вместе с ареной; блоки можно передать другой арене без
+// копирования строк.
+class StringArena {
+public:
+    static constexpr std::size_t kBlockSize = 64 * 1024;
+
+    StringArena() = default;
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+    StringArena(StringArena&&) noexcept = default;
+    StringArena& operator=(StringArena&&) noexcept = default;
+
+    char* allocate(std::size_t size) {
+        if (size > left_) {
+            const std::size_t block = std::max(kBlockSize, size);
+            blocks_.push_back(std::make_unique<char[]>(block));
+            cursor_ = blocks_.back().get();
+            left_ = block;
+            reserved_ += block;
+        }
+        char* const result = cursor_;
+        cursor_ += size;
+        left_ -= size;
+        return result;
+    }
+
+    // Забирает блоки other; строки, выданные other, остаются валидными.
+    void absorb(StringArena&& other) {
+        blocks_.reserve(blocks_.size() + other.blocks_.size());
+        for (auto& block : other.blocks_) {
+            blocks_.push_back(std::move(block));
+        }
+        reserved_ += other.reserved_;
+        other.blocks_.clear();
+        other.cursor_ = nullptr;
+        other.left_ = 0;
+        other.reserved_ = 0;
+    }
+
+    std::size_t reserved_bytes() const noexcept {
+        return reserved_;
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* cursor_{nullptr};
+    std::size_t left_{0};
+    std::size_t reserved_{0};
+};
+
+inline std::uint32_t hash_word(std::string_view word) {
+    return static_cast<std::uint32_t>(std::hash<std::string_view>{}(word));
+}
+
+// Плоская хеш-таблица «слово → частота» с открытой адресацией (линейное
+// пробирование). Рядом со слотами лежит массив управляющих байтов: 0 —
+// пусто, иначе 0x80 | 7 бит хеша, так что чужие слоты отсеиваются без
+// обращения к строке. Слово хранится в арене записью
+// [hash:4][length:4][байты], слот — это указатель на запись и счётчик.
+class WordTable {
+public:
+    WordTable() = default;
+    WordTable(const WordTable&) = delete;
+    WordTable& operator=(const WordTable&) = delete;
+    WordTable(WordTable&&) noexcept = default;
+    WordTable& operator=(WordTable&&) noexcept = default;
+
+    // Слово копируется в собственную арену только при первой вставке.
+    void increment(std::string_view word, std::uint64_t by = 1) {
+        add(word, hash_word(word), by);
+    }
+
+    // То же с готовым хешем (например, из for_each_hashed другой таблицы).
+    void add(std::string_view word, std::uint32_t hash, std::uint64_t count) {
+        const std::size_t index = find_slot(word, hash);
+        if (ctrl_[index] == kEmpty) {
+            occupy(index, hash, make_record(word, hash));
+        }
+        slots_[index].count += count;
+        total_ += count;
+    }
+
+    // Вставка без копирования: word — слово, полученное из for_each_hashed
+    // другой WordTable, чья арена живёт не меньше этой таблицы (обычно она
+    // передаётся через adopt_arena).
+    void add_interned(std::string_view word, std::uint32_t hash, std::uint64_t count) {
+        const std::size_t index = find_slot(word, hash);
+        if (ctrl_[index] == kEmpty) {
+            occupy(index, hash, word.data() - kHeaderSize);
+        }
+        slots_[index].count += count;
+        total_ += count;
+    }
+
+    // Уменьшает счётчик существующего слова (не ниже нуля). Слово с нулевым
+    // счётчиком остаётся в таблице, но при обходе его стоит пропускать.
+    void subtract(std::string_view word, std::uint64_t by) {
+        if (slots_.empty()) {
+            return;
+        }
+        const std::uint32_t hash = hash_word(word);
+        for (std::size_t index = home(hash);; index = (index + 1) & mask_) {
+            if (ctrl_[index] == kEmpty) {
+                return;
+            }
+            if (ctrl_[index] == tag(hash) && matches(slots_[index], word, hash)) {
+                const std::uint64_t removed = std::min(by, slots_[index].count);
+                slots_[index].count -= removed;
+                total_ -= removed;
+                return;
+            }
+        }
+    }
+
+    // Забирает слова и арену other; other остаётся пустой.
+    void absorb(WordTable& other) {
+        reserve(other.size());
+        other.for_each_hashed([this](std::string_view word, std::uint32_t hash, std::uint64_t count) {
+            add_interned(word, hash, count);
+        });
+        adopt_arena(other.release_arena());
+    }
+
+    std::uint64_t count(std::string_view word) const {
+        if (slots_.empty()) {
+            return 0;
+        }
+        const std::uint32_t hash = hash_word(word);
+        for (std::size_t index = home(hash);; index = (index + 1) & mask_) {
+            if (ctrl_[index] == kEmpty) {
+                return 0;
+            }
+            if (ctrl_[index] == tag(hash) && matches(slots_[index], word, hash)) {
+                return slots_[index].count;
+            }
+        }
+    }
+
+    // f(word, count) для каждой пары.
+    template <typename F>
+    void for_each(F&& f) const {
+        for (std::size_t i = 0; i < slots_.size(); ++i) {
+            if (ctrl_[i] != kEmpty) {
+                f(record_word(slots_[i].record), slots_[i].count);
+            }
+        }
+    }
+
+    // f(word, hash, count) — для слияния без пересчёта хеша.
+    template <typename F>
+    void for_each_hashed(F&& f) const {
+        for (std::size_t i = 0; i < slots_.size(); ++i) {
+            if (ctrl_[i] != kEmpty) {
+                const char* record = slots_[i].record;
+                f(record_word(record), record_hash(record), slots_[i].count);
+            }
+        }
+    }
+
+    void adopt_arena(StringArena&& arena) {
+        arena_.absorb(std::move(arena));
+    }
+
+    // Отдаёт арену со всеми словами и очищает таблицу, сохраняя ёмкость.
+    StringArena release_arena() {
+        std::fill(ctrl_.begin(), ctrl_.end(), kEmpty);
+        size_ = 0;
+        total_ = 0;
+        return std::exchange(arena_, StringArena());
+    }
+
+    // Готовит таблицу к size() + extra словам без промежуточных перестроек.
+    // Перед слиянием это обязательно: слоты другой таблицы идут в порядке
+    // их позиций, и вставка такой последовательности в меньшую таблицу с
+    // линейным пробированием слипается в длинные кластеры.
+    void reserve(std::size_t extra) {
+        std::size_t capacity = slots_.empty() ? kInitialCapacity : slots_.size();
+        while ((size_ + extra) * 4 > capacity * 3) {
+            capacity *= 2;
+        }
+        if (capacity != slots_.size()) {
+            rehash(capacity);
+        }
+    }
+
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    // Сумма всех счётчиков — сколько вхождений слов учтено.
+    std::uint64_t total() const noexcept {
+        return total_;
+    }
+
+    // Оценка занятой памяти: слоты, управляющие байты и арена.
+    std::size_t memory_bytes() const noexcept {
+        return slots_.capacity() * (sizeof(Slot) + 1) + arena_.reserved_bytes();
+    }
+
+private:
+    struct Slot {
+        const char* record;
+        std::uint64_t count;
+    };
+
+    static constexpr std::size_t kInitialCapacity = 1024;
+    static constexpr std::size_t kHeaderSize = 2 * sizeof(std::uint32_t);
+    static constexpr std::uint8_t kEmpty = 0;
+
+    static std::uint8_t tag(std::uint32_t hash) noexcept {
+        return static_cast<std::uint8_t>(0x80 | (hash >> 25));
+    }
+
+    static std::uint32_t record_hash(const char* record) noexcept {
+        std::uint32_t hash = 0;
+        std::memcpy(&hash, record, sizeof(hash));
+        return hash;
+    }
+
+    static std::string_view record_word(const char* record) noexcept {
+        std::uint32_t length = 0;
+        std::memcpy(&length, record + sizeof(std::uint32_t), sizeof(length));
+        return std::string_view(record + kHeaderSize, length);
+    }
+
+    static bool matches(const Slot& slot, std::string_view word, std::uint32_t hash) {
+        return record_hash(slot.record) == hash && record_word(slot.record) == word;
+    }
+
+    const char* make_record(std::string_view word, std::uint32_t hash) {
+        const auto length = static_cast<std::uint32_t>(word.size());
+        char* record = arena_.allocate(kHeaderSize + word.size());
+        std::memcpy(record, &hash, sizeof(hash));
+        std::memcpy(record + sizeof(hash), &length, sizeof(length));
+        std::memcpy(record + kHeaderSize, word.data(), word.size());
+        return record;
+    }
+
+    void occupy(std::size_t index, std::uint32_t hash, const char* record) {
+        ctrl_[index] = tag(hash);
+        slots_[index] = Slot{record, 0};
+        ++size_;
+    }
+
+    // Мультипликативное хеширование: старшие биты произведения. Внутри
+    // сегмента GlobalCounts младшие биты хеша совпадают, поэтому брать их
+    // нельзя. Множитель у каждой таблицы свой, так что порядок слотов одной
+    // таблицы не коррелирует с позициями в другой при слиянии.
+    std::size_t home(std::uint32_t hash) const noexcept {
+        return static_cast<std::size_t>((static_cast<std::uint64_t>(hash) * multiplier_) >> shift_);
+    }
+
+    static std::uint64_t next_multiplier() noexcept {
+        static std::atomic<std::uint64_t> counter{0};
+        // splitmix64
+        std::uint64_t z = (counter.fetch_add(1, std::memory_order_relaxed) + 1) * 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return (z ^ (z >> 31)) | 1;
+    }
+
+    std::size_t find_slot(std::string_view word, std::uint32_t hash) {
+        if ((size_ + 1) * 4 > slots_.size() * 3) {
+            grow();
+        }
+        const std::uint8_t word_tag = tag(hash);
+        for (std::size_t index = home(hash);; index = (index + 1) & mask_) {
+            if (ctrl_[index] == kEmpty ||
+                (ctrl_[index] == word_tag && matches(slots_[index], word, hash))) {
+                return index;
+            }
+        }
+    }
+
+    void grow() {
+        rehash(slots_.empty() ? kInitialCapacity : slots_.size() * 2);
+    }
+
+    void rehash(std::size_t capacity) {
+        std::vector<Slot> old_slots(capacity);
+        std::vector<std::uint8_t> old_ctrl(capacity, kEmpty);
+        old_slots.swap(slots_);
+        old_ctrl.swap(ctrl_);
+        mask_ = capacity - 1;
+        shift_ = 64;
+        for (std::size_t c = capacity; c > 1; c >>= 1) {
+            --shift_;
+        }
+
+        for (std::size_t i = 0; i < old_slots.size(); ++i) {
+            if (old_ctrl[i] == kEmpty) {
+                continue;
+            }
+            std::size_t index = home(record_hash(old_slots[i].record));
+            while (ctrl_[index] != kEmpty) {
+                index = (index + 1) & mask_;
+            }
+            ctrl_[index] = old_ctrl[i];
+            slots_[index] = old_slots[i];
+        }
+    }
+
+    std::vector<Slot> slots_;
+    std::vector<std::uint8_t> ctrl_;
+    std::size_t size_{0};
+    std::uint64_t total_{0};
+    std::size_t mask_{0};
+    unsigned shift_{64};
+    std::uint64_t multiplier_{next_multiplier()};
+    StringArena arena_;
+};
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "task_queue.hpp"
+
+enum class Scheduler {
+    Queue,  // общая очередь TaskQueue
+    Steal,  // очереди по потокам с кражей задач
+};
+
+inline Scheduler parse_scheduler(const std::string& name) {
+    if (name == "queue") {
+        return Scheduler::Queue;
+    }
+    if (name == "steal") {
+        return Scheduler::Steal;
+    }
+    throw std::runtime_error("Unknown --scheduler: " + name + " (expected queue|steal)");
+}
+
+inline const char* scheduler_name(Scheduler scheduler) {
+    return scheduler == Scheduler::Steal ? "steal" : "queue";
+}
+
+// Пул задач с кражей: у каждого worker'а своя дека под своим mutex'ом.
+// Producer раскладывает задачи по декам по кругу, worker берёт задачи с
+// головы своей деки, а когда она пуста — крадёт с хвоста чужих. Обычно
+// потоки трогают только свой mutex, так что общей точки конкуренции, как
+// у TaskQueue, нет. Засыпают worker'ы лишь когда задач нет нигде.
+class WorkStealingQueue {
+public:
+    explicit WorkStealingQueue(std::size_t workers)
+        : workers_(std::max<std::size_t>(1, workers)),
+          deques_(std::make_unique<WorkerDeque[]>(workers_)) {}
+
+    // false — очередь отменена, задача не принята.
+    bool push(Task task) {
+        WorkerDeque& target = deques_[next_.fetch_add(1, std::memory_order_relaxed) % workers_];
+        {
+            // Флаг проверяется под mutex'ом деки: cancel выставляет его до
+            // того, как опустошить деку под тем же mutex'ом, поэтому принятая
+            // задача либо достанется worker'у, либо вернётся из cancel.
+            std::lock_guard<std::mutex> lock(target.mutex);
+            if (cancelled_.load()) {
+                return false;
+            }
+            target.tasks.push_back(std::move(task));
+            pending_.fetch_add(1);
+        }
+        wake();
+        return true;
+    }
+
+    // Ждёт задачу для worker'а; false — задачи кончились и очередь закрыта.
+    bool pop(std::size_t worker, Task& out) {
+        while (true) {
+            if (take_own(worker, out) || steal(worker, out)) {
+                return true;
+            }
+
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            sleepers_.fetch_add(1);
+            cv_.wait(lock, [this] { return pending_.load() != 0 || closed_; });
+            sleepers_.fetch_sub(1);
+            if (pending_.load() == 0 && closed_) {
+                return false;
+            }
+        }
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    // Закрывает очередь и возвращает задачи, которые никто не успел взять.
+    std::vector<Task> cancel() {
+        cancelled_.store(true);
+        std::vector<Task> dropped;
+        for (std::size_t i = 0; i < workers_; ++i) {
+            std::lock_guard<std::mutex> lock(deques_[i].mutex);
+            for (Task& task : deques_[i].tasks) {
+                dropped.push_back(std::move(task));
+            }
+            pending_.fetch_sub(deques_[i].tasks.size());
+            deques_[i].tasks.clear();
+        }
+        close();
+        return dropped;
+    }
+
+    std::uint64_t steals() const noexcept {
+        return steals_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct alignas(64) WorkerDeque {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool take_own(std::size_t worker, Task& out) {
+        WorkerDeque& own = deques_[worker % workers_];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.tasks.empty()) {
+            return false;
+        }
+        out = std::move(own.tasks.front());
+        own.tasks.pop_front();
+        pending_.fetch_sub(1);
+        return true;
+    }
+
+    bool steal(std::size_t worker, Task& out) {
+        for (std::size_t i = 1; i < workers_; ++i) {
+            WorkerDeque& victim = deques_[(worker + i) % workers_];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.tasks.empty()) {
+                continue;
+            }
+            out = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            pending_.fetch_sub(1);
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    // pending_ увеличивается до проверки sleepers_, а worker увеличивает
+    // sleepers_ до проверки pending_ (оба seq_cst), поэтому либо worker
+    // увидит задачу, либо producer увидит спящего и разбудит его.
+    // Захват wake_mutex_ гарантирует, что worker между проверкой условия
+    // и засыпанием не пропустит уведомление.
+    void wake() {
+        if (sleepers_.load() == 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+        }
+        cv_.notify_one();
+    }
+
+    std::size_t workers_;
+    std::unique_ptr<WorkerDeque[]> deques_;
+    std::atomic<std::size_t> next_{0};
+
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> sleepers_{0};
+    std::atomic<std::uint64_t> steals_{0};
+    std::atomic<bool> cancelled_{false};
+    bool closed_{false};
+    std::mutex wake_mutex_;
+    std::condition_variable cv_;
+};